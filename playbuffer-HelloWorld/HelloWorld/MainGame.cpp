@@ -42,6 +42,17 @@ enum GameScreen
 };
 
 GameScreen currentGameScreen = STATE_START;
+//The last screen drawn to the window, so screens that don't change only get drawn once
+GameScreen drawnScreen = STATE_MAIN_GAME;
+
+//HUD text is drawn into render layers, which only get redrawn when the text on them changes
+const char* HUD_BANNER_TEXT = "ARROW KEYS TO MOVE UP AND DOWN AND SPACE TO FIRE";
+const char* HUD_MUTE_TEXT = "TOGGLE M TO MUTE / UNMUTE";
+int hudBannerLayer = -1;
+int hudMuteLayer = -1;
+int hudStatsLayer = -1;
+int hudShownScore = -1;
+int hudShownLives = -1;
 
 enum Agent8State
 {
@@ -78,6 +89,16 @@ enum GameObjectType
 	TYPE_DESTROYED,
 };
 
+//Collision layers, only the layers set up in MainGameEntry collide with each other
+enum CollisionLayer
+{
+	LAYER_NONE = 0,
+	LAYER_AGENT8,
+	LAYER_LASER,
+	LAYER_TOOL,
+	LAYER_COIN,
+};
+
 //Function Declarations
 void HandlePlayerControls();
 void UpdateFan();
@@ -86,6 +107,7 @@ void UpdateCoinsAndStars();
 void UpdateLasers();
 void UpdateDestroyed();
 void UpdateAgent8();
+void HandleCollisions();
 void DrawStartScreen();
 void DrawGameOverScreen();
 void DrawExtraLifeText();
@@ -93,6 +115,9 @@ void DrawBonusLevelText();
 //void DrawSpeedUpText();
 void ResetGameState();
 void DestroyAllObjects();
+void DrawHud();
+int CreateTextLayer(const char* text);
+void DrawTextLayerCentred(int layer, const char* text, Point2D pos);
 
 // The entry point for a PlayBuffer program used instead of Main
 void MainGameEntry( PLAY_IGNORE_COMMAND_LINE )
@@ -102,6 +127,15 @@ void MainGameEntry( PLAY_IGNORE_COMMAND_LINE )
 	//Moves local origins to centre
 	Play::CentreAllSpriteOrigins();
 	Play::LoadBackground("Data\\Backgrounds\\background.png");
+	//Agent8 can be hit by tools and collect coins, lasers destroy both
+	Play::SetLayerCollision(LAYER_AGENT8, LAYER_TOOL, true);
+	Play::SetLayerCollision(LAYER_AGENT8, LAYER_COIN, true);
+	Play::SetLayerCollision(LAYER_LASER, LAYER_TOOL, true);
+	Play::SetLayerCollision(LAYER_LASER, LAYER_COIN, true);
+	//Each line of instructions gets a layer just big enough for its text, the score and lives cover the top left corner
+	hudBannerLayer = CreateTextLayer(HUD_BANNER_TEXT);
+	hudMuteLayer = CreateTextLayer(HUD_MUTE_TEXT);
+	hudStatsLayer = Play::CreateRenderLayer(DISPLAY_WIDTH / 2, 140);
 
 	currentGameScreen = STATE_START;
 }
@@ -129,13 +163,13 @@ bool MainGameUpdate( float elapsedTime )
 		if (!gameStarted) {
 			// The game has just started, do the initialization here.
 			Play::CentreAllSpriteOrigins();
-			Play::LoadBackground("Data\\Backgrounds\\background.png");
 
 			if (isAudioPlaying) {
 				Play::StartAudioLoop("music");
 			}
 	
-			Play::CreateGameObject(TYPE_AGENT8, { 115, 0 }, 50, "agent8");
+			int id_agent8 = Play::CreateGameObject(TYPE_AGENT8, { 115, 0 }, 50, "agent8");
+			Play::GetGameObject(id_agent8).collisionLayer = LAYER_AGENT8;
 			int id_fan = Play::CreateGameObject(TYPE_FAN, { 1140, 217 }, 0, "fan");
 			Play::GetGameObject(id_fan).velocity = { 0, 3 };
 			Play::GetGameObject(id_fan).animSpeed = 1.0f;
@@ -152,17 +186,12 @@ bool MainGameUpdate( float elapsedTime )
 		UpdateCoinsAndStars();
 		UpdateLasers();
 		UpdateDestroyed();
+		//Finds all the collisions in one go, now everything has moved to where it was drawn
+		Play::UpdateCollisions();
+		HandleCollisions();
 
-		//Play instructions and controls
-		Play::DrawFontText("64px", "ARROW KEYS TO MOVE UP AND DOWN AND SPACE TO FIRE",
-			{ DISPLAY_WIDTH / 2, 30 }, Play::CENTRE);
-		Play::DrawFontText("64px", "TOGGLE M TO MUTE / UNMUTE",
-			{ DISPLAY_WIDTH / 2, DISPLAY_HEIGHT - 30 }, Play::CENTRE);
-
-		//Life and score HUD
-		Play::DrawFontText("64px", "SCORE: " + std::to_string(gameState.score),
-			{ 100, 50 }, Play::CENTRE);
-		Play::DrawFontText("64px", "Lives: " + std::to_string(gameState.lives), { 100, 100 }, Play::CENTRE);
+		//Play instructions and controls, lives and score
+		DrawHud();
 
 		
 		//If the extra life boolean is true
@@ -203,6 +232,7 @@ bool MainGameUpdate( float elapsedTime )
 		
 		//Displays current Drawings on Screen
 		Play::PresentDrawingBuffer();
+		drawnScreen = STATE_MAIN_GAME;
 
 		//If the user presses M Stop and Start audio
 		if (Play::KeyPressed('M')) {
@@ -281,6 +311,7 @@ void HandlePlayerControls()
 		Vector2D firePos = obj_agent8.pos + Vector2D(155, -75);
 		int id = Play::CreateGameObject(TYPE_LASER, firePos, 30, "laser");
 		Play::GetGameObject(id).velocity = { 32, 0 };
+		Play::GetGameObject(id).collisionLayer = LAYER_LASER;
 		Play::PlayAudio("shoot");
 	}
 	Play::UpdateGameObject(obj_agent8);
@@ -307,6 +338,7 @@ void UpdateFan()
 			GameObject& obj_coin = Play::GetGameObject(id);
 			obj_coin.velocity = { -3, 0 };
 			obj_coin.rotSpeed = 0.1f;
+			obj_coin.collisionLayer = LAYER_COIN;
 			Play::PlayAudio("collect");
 		}
 		else {
@@ -316,6 +348,7 @@ void UpdateFan()
 			GameObject& obj_tool = Play::GetGameObject(id);
 			//Sets the direction of the tool and then times by 6 to set Y Axis Velocity
 			obj_tool.velocity = Point2f(-8, Play::RandomRollRange(-1, 1) * 6);
+			obj_tool.collisionLayer = LAYER_TOOL;
 
 			//Gives chance for tool to turn into spanner
 			if (Play::RandomRoll(2) == 1)
@@ -338,6 +371,7 @@ void UpdateFan()
 		GameObject& obj_coin = Play::GetGameObject(id);
 		obj_coin.velocity = { -3, 0 };
 		obj_coin.rotSpeed = 0.1f;
+		obj_coin.collisionLayer = LAYER_COIN;
 	}
 	Play::UpdateGameObject(obj_fan);
 
@@ -349,22 +383,38 @@ void UpdateFan()
 	Play::DrawObject(obj_fan);
 }
 
-//Used for attacking tools and collision
-void UpdateTools()
+//Applies the effects of all the collisions found this frame by Play::UpdateCollisions
+void HandleCollisions()
 {
-	//Needs to get agent8 to detect collisions
-	GameObject& obj_agent8 = Play::GetGameObjectByType(TYPE_AGENT8);
-	
-	//Stores the ID of all the tool objects within a Vector
-	std::vector<int> vTools = Play::CollectGameObjectIDsByType(TYPE_TOOL);
+	//Coins that have been collected and lasers that have hit something are only destroyed at the end of the frame,
+	//so they're remembered here to stop them being hit a second time
+	std::vector<int> vUsedIDs;
 
-	//For Loop assigns values to each item in the vector
-	for (int id : vTools)
+	//The pairs are sorted by the object on the lower layer, so agent8 or the laser always comes first
+	for (const Play::CollisionPair& pair : Play::GetCollisionPairs())
 	{
-		GameObject& obj_tool = Play::GetGameObject(id);
+		//Objects that have stopped touching don't do anything
+		if (pair.state == Play::COLLISION_EXIT)
+			continue;
+
+		//Skip anything that has already been collected or hit this frame
+		if (std::find(vUsedIDs.begin(), vUsedIDs.end(), pair.idA) != vUsedIDs.end() ||
+			std::find(vUsedIDs.begin(), vUsedIDs.end(), pair.idB) != vUsedIDs.end())
+			continue;
+
+		GameObject& obj_a = Play::GetGameObject(pair.idA);
+		GameObject& obj_b = Play::GetGameObject(pair.idB);
+
 		//If Agent is Not Dead and they are not currently in invincibility frames and there is a collision
-		if (gameState.agentState != STATE_DEAD && !isPlayerInvincible && Play::IsColliding(obj_tool, obj_agent8))
+		if (obj_a.GetType() == TYPE_AGENT8 && obj_b.GetType() == TYPE_TOOL)
 		{
+			if (gameState.agentState == STATE_DEAD || isPlayerInvincible)
+				continue;
+
+			//The spanner is an awkward shape for a circle, so only count hits where the sprites actually touch
+			if (!Play::IsCollidingPixel(obj_a, obj_b))
+				continue;
+
 			Play::PlayAudio("die");
 
 			//Lives are reduced
@@ -378,9 +428,9 @@ void UpdateTools()
 			if (gameState.lives > 0)
 			{
 				gameState.agentState = STATE_APPEAR;
-				obj_agent8.pos = { 115, 0 };
-				obj_agent8.velocity = { 0, 0 };
-				obj_agent8.frame = 0;
+				obj_a.pos = { 115, 0 };
+				obj_a.velocity = { 0, 0 };
+				obj_a.frame = 0;
 			}
 
 			//If no lifes left, play explode sound and start game over screen
@@ -391,7 +441,59 @@ void UpdateTools()
 				currentGameScreen = STATE_GAME_OVER;
 			}
 		}
+		//If the player is colliding with a coin
+		else if (obj_a.GetType() == TYPE_AGENT8 && obj_b.GetType() == TYPE_COIN)
+		{
+			//show rotating stars 
+			//Creates four stars in the corner of the coin 
+			for (float rad{ 0.25f }; rad < 2.0f; rad += 0.5f)
+			{
+				int id = Play::CreateGameObject(TYPE_STAR, obj_a.pos, 0, "star");
+				GameObject& obj_star = Play::GetGameObject(id);
+				obj_star.rotSpeed = 0.1f;
+				obj_star.acceleration = { 0.0f, 0.5f };
+				Play::SetGameObjectDirection(obj_star, 16, rad * PLAY_PI);
+			}
+			//Not destroyed straight away so it is still drawn this frame
+			Play::DestroyGameObjectDeferred(pair.idB);
+			vUsedIDs.push_back(pair.idB);
+			
+			//Increase score and play sound
+			gameState.score += 500;
+			Play::PlayAudio("collect");
+		}
+		//If colliding between laser and tool
+		else if (obj_a.GetType() == TYPE_LASER && obj_b.GetType() == TYPE_TOOL)
+		{
+			//Laser is destroyed at the end of the frame, type set to destroy so it fades, points incremented
+			Play::DestroyGameObjectDeferred(pair.idA);
+			vUsedIDs.push_back(pair.idA);
+			Play::SetGameObjectType(obj_b, TYPE_DESTROYED);
+			gameState.score += 100;
+		}
+		//If colliding between laser and coin
+		else if (obj_a.GetType() == TYPE_LASER && obj_b.GetType() == TYPE_COIN)
+		{
+			//Laser is destroyed at the end of the frame, set to destroy so it fades, points decremented
+			Play::DestroyGameObjectDeferred(pair.idA);
+			vUsedIDs.push_back(pair.idA);
+			Play::SetGameObjectType(obj_b, TYPE_DESTROYED);
+			Play::PlayAudio("error");
+			gameState.score -= 200;
+		}
+	}
+
+	//Checker that stops game score dropping below 0
+	if (gameState.score < 0)
+		gameState.score = 0;
+}
 
+//Used for attacking tools
+void UpdateTools()
+{
+	//Moves every tool object, spread over all the cores
+	Play::ParallelUpdateGameObjects(TYPE_TOOL, [](GameObject& obj_tool, GameObjectCommands& commands)
+	{
 		Play::UpdateGameObject(obj_tool);
 
 		//Checker for if object is leaving
@@ -402,18 +504,15 @@ void UpdateTools()
 		}
 		Play::DrawObjectRotated(obj_tool);
 		
-		//If object is not in play then destory it 
+		//If object is not in play then destory it once they've all moved
 		if (!Play::IsVisible(obj_tool))
-			Play::DestroyGameObject(id);
-	}
+			commands.DestroyGameObject(obj_tool.GetId());
+	});
 }
 
 //Used for collectables
 void UpdateCoinsAndStars()
 {
-	//Agent 8 needed here for collision
-	GameObject& obj_agent8 = Play::GetGameObjectByType(TYPE_AGENT8);
-	
 	//All collectables ID's are stored in a vector
 	std::vector<int> vCoins = Play::CollectGameObjectIDsByType(TYPE_COIN);
 	
@@ -421,29 +520,6 @@ void UpdateCoinsAndStars()
 	for (int id_coin : vCoins)
 	{
 		GameObject& obj_coin = Play::GetGameObject(id_coin);
-		//sets collision to false
-		bool hasCollided = false;
-		//Then if the player is coliding 
-		if (Play::IsColliding(obj_coin, obj_agent8))
-		{
-			//show rotating stars 
-			//Creates four stars in the corner of the coin 
-			for (float rad{ 0.25f }; rad < 2.0f; rad += 0.5f)
-			{
-				int id = Play::CreateGameObject(TYPE_STAR, obj_agent8.pos, 0, "star");
-				GameObject& obj_star = Play::GetGameObject(id);
-				obj_star.rotSpeed = 0.1f;
-				obj_star.acceleration = { 0.0f, 0.5f };
-				Play::SetGameObjectDirection(obj_star, 16, rad * PLAY_PI);
-			}
-			//Colliision marker set to true 
-			//Not destroyed straight away as would crash due to still trying to access the object
-			hasCollided = true;
-			
-			//Increase score and play sound
-			gameState.score += 500;
-			Play::PlayAudio("collect");
-		}
 
 		//If the current score is bigger than or equal to the next score needed for an extra life
 		if (gameState.score >= gameState.scoreForNextLife)
@@ -464,101 +540,54 @@ void UpdateCoinsAndStars()
 			DrawBonusLevelText();
 		}
 
-		//Update GameObjects and Position (Outside of IF)
+		//Update GameObjects and Position
 		Play::UpdateGameObject(obj_coin);
 		Play::DrawObjectRotated(obj_coin);
-		//If the object is no longer visible or has previously collided
-		//Then destroy
-		if (!Play::IsVisible(obj_coin) || hasCollided)
+		//If the object is no longer visible then destroy (collected coins are destroyed at the end of the frame)
+		if (!Play::IsVisible(obj_coin))
 			Play::DestroyGameObject(id_coin);
 	}
-	std::vector<int> vStars = Play::CollectGameObjectIDsByType(TYPE_STAR);
-	for (int id_star : vStars)
+	Play::ParallelUpdateGameObjects(TYPE_STAR, [](GameObject& obj_star, GameObjectCommands& commands)
 	{
-		GameObject& obj_star = Play::GetGameObject(id_star);
 		Play::UpdateGameObject(obj_star);
 		Play::DrawObjectRotated(obj_star);
 		//Once no longer visible, destroy star
 		if (!Play::IsVisible(obj_star))
-			Play::DestroyGameObject(id_star);
-	}
+			commands.DestroyGameObject(obj_star.GetId());
+	});
 }
 
 //Lasers for Agent 8
 void UpdateLasers()
 {
-	//Needed for collision on objects
-	std::vector<int> vLasers = Play::CollectGameObjectIDsByType(TYPE_LASER);
-	std::vector<int> vTools = Play::CollectGameObjectIDsByType(TYPE_TOOL);
-	std::vector<int> vCoins = Play::CollectGameObjectIDsByType(TYPE_COIN);
-
-	//for all the laser objects
-	for (int id_laser : vLasers)
+	//for all the laser objects (lasers that hit something are destroyed at the end of the frame)
+	Play::ForEachGameObject(TYPE_LASER, [](GameObject& obj_laser)
 	{
-		GameObject& obj_laser = Play::GetGameObject(id_laser);
-		//Collision set to false
-		bool hasCollided = false;
-		
-		//for all the tools
-		for (int id_tool : vTools)
-		{
-			GameObject& obj_tool = Play::GetGameObject(id_tool);
-			//If colliding between laser and tool
-			if (Play::IsColliding(obj_laser, obj_tool))
-			{
-				//Collison is set to true, type set to destroy so it fades, points incremented
-				hasCollided = true;
-				obj_tool.type = TYPE_DESTROYED;
-				gameState.score += 100;
-			}
-		}
-		//for coins
-		for (int id_coin : vCoins)
-		{
-			GameObject& obj_coin = Play::GetGameObject(id_coin);
-			//If colliding between laser and coin
-			if (Play::IsColliding(obj_laser, obj_coin))
-			{
-				//Collision set to true, set to destroy so it fades, points decremented
-				hasCollided = true;
-				obj_coin.type = TYPE_DESTROYED;
-				Play::PlayAudio("error");
-				gameState.score -= 200;
-			}
-		}
-		//Checker that stops game score dropping below 0
-		if (gameState.score < 0)
-			gameState.score = 0;
-		
 		if (gameState.lives <= 0) {
 			currentGameScreen = STATE_GAME_OVER;
 		}
 
 		Play::UpdateGameObject(obj_laser);
 		Play::DrawObject(obj_laser);
-		//If laser is no longer on screen or has collided then the laser is destroyed.
-		if (!Play::IsVisible(obj_laser) || hasCollided)
-			Play::DestroyGameObject(id_laser);
-	}
+		//If laser is no longer on screen then the laser is destroyed.
+		if (!Play::IsVisible(obj_laser))
+			Play::DestroyGameObject(obj_laser.GetId());
+	});
 }
 
-//For all objects that are waiting to be destroyed
+//For all objects that have been hit and are fading out
 //Allows existance until they become invisble or are dead for 10 frames or more
-//Allows the rest of the code relating to the object to be completed before the object is destroyed
-//Stops errors from accessing a destroyed object.
 void UpdateDestroyed()
 {
-	std::vector<int> vDead = Play::CollectGameObjectIDsByType(TYPE_DESTROYED);
-	for (int id_dead : vDead)
+	Play::ForEachGameObject(TYPE_DESTROYED, [](GameObject& obj_dead)
 	{
-		GameObject& obj_dead = Play::GetGameObject(id_dead);
 		obj_dead.animSpeed = 0.2f;
 		Play::UpdateGameObject(obj_dead);
 		if (obj_dead.frame % 2)
 			Play::DrawObjectRotated(obj_dead, (10 - obj_dead.frame) / 10.0f);
 		if (!Play::IsVisible(obj_dead) || obj_dead.frame >= 10)
-			Play::DestroyGameObject(id_dead);
-	}
+			Play::DestroyGameObject(obj_dead.GetId());
+	});
 }
 
 //Improving game smoothness by having custom states
@@ -589,8 +618,8 @@ void UpdateAgent8()
 		//Start timer
 		if (isPlayerInvincible)
 		{
-			//Timer linked to frames as a work around of not being able to pass elapsed timer 
-			invincibilityTimer -= 1.0f / 60.0f; 
+			//Counts down by the simulated time of one update, so it still lasts the same with a fixed timestep
+			invincibilityTimer -= Play::GetSimulationTimestep();
 			if (invincibilityTimer <= 0.0f)
 			{
 				//Gets rid of invincibility frames
@@ -618,7 +647,7 @@ void UpdateAgent8()
 			gameState.score = 0;
 	
 			for (int id_obj : Play::CollectGameObjectIDsByType(TYPE_TOOL))
-				Play::GetGameObject(id_obj).type = TYPE_DESTROYED;
+				Play::SetGameObjectType(Play::GetGameObject(id_obj), TYPE_DESTROYED);
 		}
 		break;
 	} // End of switch on Agent8State
@@ -632,23 +661,74 @@ void UpdateAgent8()
 }
 
 
+//Creates a render layer for a line of HUD text, the width of the text and the height of the font
+int CreateTextLayer(const char* text) {
+	return Play::CreateRenderLayer(Play::GetFontTextWidth("64px", text), Play::GetSpriteHeight("64px"));
+}
+
+//Draws a layer made by CreateTextLayer where DrawFontText would draw the text centred on pos
+//The text is only drawn into the layer again if the layer is dirty
+void DrawTextLayerCentred(int layer, const char* text, Point2D pos) {
+	Point2D origin = Play::GetSpriteOrigin("64px");
+	if (Play::IsRenderLayerDirty(layer)) {
+		Play::BeginRenderLayer(layer);
+		Play::DrawFontText("64px", text, { 0, origin.y }, Play::LEFT);
+		Play::EndRenderLayer();
+	}
+	Play::DrawRenderLayer(layer, { pos.x - Play::GetFontTextWidth("64px", text) / 2, pos.y - origin.y });
+}
+
+//Draws the instructions and the life and score HUD
+//The text is only drawn again when the score or lives change, otherwise the cached layers are reused
+void DrawHud() {
+	DrawTextLayerCentred(hudBannerLayer, HUD_BANNER_TEXT, { DISPLAY_WIDTH / 2, 30 });
+	DrawTextLayerCentred(hudMuteLayer, HUD_MUTE_TEXT, { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT - 30 });
+
+	if (gameState.score != hudShownScore || gameState.lives != hudShownLives) {
+		Play::SetRenderLayerDirty(hudStatsLayer);
+	}
+	if (Play::IsRenderLayerDirty(hudStatsLayer)) {
+		Play::BeginRenderLayer(hudStatsLayer);
+		Play::DrawFontText("64px", "SCORE: " + std::to_string(gameState.score),
+			{ 100, 50 }, Play::CENTRE);
+		Play::DrawFontText("64px", "Lives: " + std::to_string(gameState.lives), { 100, 100 }, Play::CENTRE);
+		Play::EndRenderLayer();
+		hudShownScore = gameState.score;
+		hudShownLives = gameState.lives;
+	}
+
+	Play::DrawRenderLayer(hudStatsLayer);
+}
+
 //Used to draw the starting screen
 void DrawStartScreen() {
+	//Nothing on the start screen changes, so once it's shown the frame is skipped until a key is pressed
+	if (drawnScreen == STATE_START) {
+		Play::MarkFrameUnchanged();
+		return;
+	}
 	Play::ClearDrawingBuffer(Play::cBlack);
 	Play::DrawFontText("64px", "HIT SPACE TO START GAME",
 		{ DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 100 }, Play::CENTRE);
 	Play::DrawFontText("64px", "Bonus Life Every: 9000 Points", { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 30 }, Play::CENTRE);
 	Play::DrawFontText("64px", "Bonus Round Every: 20000 Points", { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - -10 }, Play::CENTRE);
 	Play::PresentDrawingBuffer();
+	drawnScreen = STATE_START;
 }
 
 //Used to draw the game over screen
 void DrawGameOverScreen() {
+	//The final score can't change either, so the game over screen is only drawn once too
+	if (drawnScreen == STATE_GAME_OVER) {
+		Play::MarkFrameUnchanged();
+		return;
+	}
 	Play::ClearDrawingBuffer(Play::cBlack);
 	Play::DrawFontText("64px", "Game Over",{ DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 100 }, Play::CENTRE);
 	Play::DrawFontText("64px", "Your Score: " + std::to_string(gameState.score), { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 50 }, Play::CENTRE);
 	Play::DrawFontText("64px", "Press Space To Restart", { DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2 - 5 }, Play::CENTRE);
 	Play::PresentDrawingBuffer();
+	drawnScreen = STATE_GAME_OVER;
 }
 
 //Sets boolean to true
@@ -681,11 +761,5 @@ void ResetGameState() {
 
 //Used to ensure all objects are destroyed when game is restarted.
 void DestroyAllObjects() {
-	Play::DestroyGameObjectsByType(TYPE_AGENT8);
-	Play::DestroyGameObjectsByType(TYPE_FAN);
-	Play::DestroyGameObjectsByType(TYPE_TOOL);
-	Play::DestroyGameObjectsByType(TYPE_COIN);
-	Play::DestroyGameObjectsByType(TYPE_STAR);
-	Play::DestroyGameObjectsByType(TYPE_LASER);
-	Play::DestroyGameObjectsByType(TYPE_DESTROYED);
+	Play::DestroyAllGameObjects();
 }
\ No newline at end of file
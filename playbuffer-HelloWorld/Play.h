@@ -41,6 +41,17 @@
 #include <filesystem>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
 #define WIN32_LEAN_AND_MEAN // Exclude rarely-used content from the Windows headers
 #define NOMINMAX // Stop windows macros defining their own min and max macros
@@ -893,6 +904,107 @@ inline void Matrix2D::Inverse()
 	row[2] = Vector3f( c02, c12, c22 );
 }
 
+// Returns true if the processor (and operating system) support AVX, so eight floats can be processed at a time
+// > The AVX code paths are compiled without /arch:AVX (or -mavx) and chosen at run time, so the game still runs on older processors
+inline bool CpuSupportsAvx()
+{
+	static const bool bAvx = []()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid( info, 1 );
+		unsigned int ecx = static_cast<unsigned int>( info[2] );
+#else
+		unsigned int eax, ebx, ecx, edx;
+		if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+			return false;
+#endif
+
+		// ECX bit 27 is OSXSAVE and bit 28 is AVX, then XCR0 says whether the OS saves the SSE and AVX registers
+		if( ( ecx & ( 1u << 27 ) ) == 0 || ( ecx & ( 1u << 28 ) ) == 0 )
+			return false;
+
+#ifdef _MSC_VER
+		return ( _xgetbv( 0 ) & 6 ) == 6;
+#else
+		// GCC and Clang only provide _xgetbv when compiling for XSAVE, so the instruction is used directly
+		unsigned int xcr0Low, xcr0High;
+		__asm__( "xgetbv" : "=a"( xcr0Low ), "=d"( xcr0High ) : "c"( 0 ) );
+		return ( xcr0Low & 6 ) == 6;
+#endif
+	}();
+
+	return bAvx;
+}
+
+// MSVC allows AVX intrinsics anywhere, but GCC and Clang only in functions compiled for AVX
+#ifdef _MSC_VER
+#define PLAY_TARGET_AVX
+#else
+#define PLAY_TARGET_AVX __attribute__(( target( "avx" ) ))
+#endif
+
+// The AVX part of CollideCircles, which tests eight circles at a time and returns how many circles it has tested
+// > Only call it if CpuSupportsAvx() returns true
+PLAY_TARGET_AVX inline int CollideCirclesAvx( Vector2f pos, float radius, const float* pX, const float* pY, const float* pRadius, int count, uint32_t* pHitMasks )
+{
+	const __m256 posX8 = _mm256_set1_ps( pos.x );
+	const __m256 posY8 = _mm256_set1_ps( pos.y );
+	const __m256 radius8 = _mm256_set1_ps( radius );
+
+	int i = 0;
+	for( ; i + 8 <= count; i += 8 )
+	{
+		__m256 xDiff = _mm256_sub_ps( _mm256_loadu_ps( pX + i ), posX8 );
+		__m256 yDiff = _mm256_sub_ps( _mm256_loadu_ps( pY + i ), posY8 );
+		__m256 radii = _mm256_add_ps( _mm256_loadu_ps( pRadius + i ), radius8 );
+		__m256 distSqr = _mm256_add_ps( _mm256_mul_ps( xDiff, xDiff ), _mm256_mul_ps( yDiff, yDiff ) );
+		uint32_t hits = static_cast<uint32_t>( _mm256_movemask_ps( _mm256_cmp_ps( distSqr, _mm256_mul_ps( radii, radii ), _CMP_LT_OQ ) ) );
+		pHitMasks[i >> 5] |= hits << ( i & 31 );
+	}
+
+	// Avoids the penalty for switching back to the SSE code which follows
+	_mm256_zeroupper();
+	return i;
+}
+
+// Tests one circle against arrays of circle positions and radii, setting bit i of the hit masks if circle i overlaps it
+// > pHitMasks needs ( count + 31 ) / 32 elements. Circles which are only touching don't count as overlapping
+inline void CollideCircles( Vector2f pos, float radius, const float* pX, const float* pY, const float* pRadius, int count, uint32_t* pHitMasks )
+{
+	for( int i = 0; i < ( count + 31 ) / 32; i++ )
+		pHitMasks[i] = 0;
+
+	int i = 0;
+
+	if( CpuSupportsAvx() )
+		i = CollideCirclesAvx( pos, radius, pX, pY, pRadius, count, pHitMasks );
+
+	const __m128 posX4 = _mm_set1_ps( pos.x );
+	const __m128 posY4 = _mm_set1_ps( pos.y );
+	const __m128 radius4 = _mm_set1_ps( radius );
+
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 xDiff = _mm_sub_ps( _mm_loadu_ps( pX + i ), posX4 );
+		__m128 yDiff = _mm_sub_ps( _mm_loadu_ps( pY + i ), posY4 );
+		__m128 radii = _mm_add_ps( _mm_loadu_ps( pRadius + i ), radius4 );
+		__m128 distSqr = _mm_add_ps( _mm_mul_ps( xDiff, xDiff ), _mm_mul_ps( yDiff, yDiff ) );
+		uint32_t hits = static_cast<uint32_t>( _mm_movemask_ps( _mm_cmplt_ps( distSqr, _mm_mul_ps( radii, radii ) ) ) );
+		pHitMasks[i >> 5] |= hits << ( i & 31 );
+	}
+
+	for( ; i < count; i++ )
+	{
+		float xDiff = pX[i] - pos.x;
+		float yDiff = pY[i] - pos.y;
+		float radii = pRadius[i] + radius;
+
+		if( ( xDiff * xDiff ) + ( yDiff * yDiff ) < radii * radii )
+			pHitMasks[i >> 5] |= 1u << ( i & 31 );
+	}
+}
+
 
 #endif
 
@@ -979,7 +1091,7 @@ struct MouseData
 // Notes:		Uses a 32-bit ARGB display buffer
 //********************************************************************************************************************************
 
-// The target frame rate
+// The target frame rate (unless it's changed with PlayWindow::SetTargetFrameRate)
 constexpr int FRAMES_PER_SECOND = 60;
 
 // Some defines to hide the complexity of arguments 
@@ -1013,7 +1125,37 @@ public:
 	static LRESULT CALLBACK WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam );
 	// Copies the display buffer pixels to the window
 	// > Returns the time taken for the present in seconds
-	double Present();
+	double Present() { return Present( *m_pPlayBuffer ); }
+	// Copies the pixels of a buffer the same size as the display buffer to the window
+	double Present( const PixelData& displayBuffer );
+	// Sets whether Present waits for the compositor after copying to the window, instead of the main loop waiting after each frame
+	// > This is for presenting on another thread, so that the game thread never waits for the compositor
+	void SetPresentWaits( bool wait ) { m_bPresentWaits = wait; }
+
+	// Frame pacing functions
+	//********************************************************************************************************************************
+
+	// Sets the number of frames per second the main loop runs at (0 to run as fast as it can)
+	// > Between frames the loop sleeps until just before the next one is due, and only spins for the last fraction of a millisecond
+	void SetTargetFrameRate( int framesPerSecond );
+	// Gets the number of frames per second the main loop is aiming for (0 if it isn't limited)
+	int GetTargetFrameRate() const { return m_targetFrameRate; }
+	// Gets the time between the last two frames in milliseconds
+	float GetFrameTime() const { return m_frameTime; }
+	// Gets the average time between frames in milliseconds, over the last PACING_HISTORY frames
+	float GetFrameTimeAverage() const { return m_frameTimeAverage; }
+	// Gets the standard deviation of the time between frames in milliseconds, over the last PACING_HISTORY frames
+	float GetFrameTimeJitter() const { return m_frameTimeJitter; }
+	// Gets the furthest a frame was from its due time in milliseconds, over the last PACING_HISTORY frames
+	float GetFrameTimeWorstError() const { return m_frameTimeWorstError; }
+	// Gets the time the last call to MainGameUpdate took in milliseconds (the frame time without any waiting between frames)
+	float GetUpdateTime() const { return m_updateTime; }
+	// Tells the main loop that nothing was drawn or presented this frame (e.g. on a menu screen which hasn't changed)
+	// > Instead of waiting for the next frame to be due, the loop then waits until there is some input, or IDLE_WAIT_MS has passed
+	void MarkFrameUnchanged() { m_bFrameUnchanged = true; }
+	// Checks whether Windows has asked for the window to be repainted (e.g. after it was uncovered) since the last call
+	// > Frames which are marked as unchanged don't present anything, so the last frame has to be presented again instead
+	bool TakeRepaintRequest() { bool bRepaint = m_bRepaintRequested; m_bRepaintRequested = false; return bRepaint; }
 	// Sets the pointer to write mouse input data to
 	void RegisterMouse( MouseData* pMouseData ) { m_pMouseData = pMouseData; }
 
@@ -1052,9 +1194,38 @@ private:
 	// Miscellaneous internal functions
 	//********************************************************************************************************************************
 
+	// Waits until the next frame is due, then returns the time since the last one in milliseconds
+	double WaitForNextFrame( LARGE_INTEGER lastDrawTime, LARGE_INTEGER frequency, LARGE_INTEGER& now );
+	// Adds the time between two frames to the pacing statistics
+	void RecordFrameTime( double frameTime );
+
 	// Display buffer dimensions
 	int m_scale{ 0 };
 
+	// The number of frames the pacing statistics cover
+	static constexpr int PACING_HISTORY = 120;
+	// How long before a frame is due to stop sleeping and spin, for each kind of timer (in milliseconds)
+	// > High resolution timers wake up within about half a millisecond, but Sleep can be up to a whole timer period late
+	static constexpr double PACING_SPIN_HIGH_RESOLUTION = 0.5;
+	static constexpr double PACING_SPIN_SLEEP = 1.5;
+	// The longest the main loop waits for input after an unchanged frame, so that the game still sees time passing
+	static constexpr DWORD IDLE_WAIT_MS = 100;
+
+	int m_targetFrameRate{ FRAMES_PER_SECOND };
+	// A high resolution waitable timer, or nullptr if the system doesn't have them and Sleep is used instead
+	HANDLE m_hFrameTimer{ nullptr };
+	double m_vFrameTimes[PACING_HISTORY]{};
+	int m_frameTimeCount{ 0 };
+	float m_frameTime{ 0.0f };
+	float m_frameTimeAverage{ 0.0f };
+	float m_frameTimeJitter{ 0.0f };
+	float m_frameTimeWorstError{ 0.0f };
+	float m_updateTime{ 0.0f };
+	// Set when the game marks a frame as unchanged, until the main loop has waited for input
+	bool m_bFrameUnchanged{ false };
+	// Set by WM_PAINT, until the last frame has been presented again
+	bool m_bRepaintRequested{ false };
+
 	// Buffer pointers
 	PixelData* m_pPlayBuffer{ nullptr };
 	//Pointer to external mouse data
@@ -1063,6 +1234,8 @@ private:
 	static PlayWindow* s_pInstance;
 	// The handle to the Window 
 	HWND m_hWindow{ nullptr };
+	// Whether Present waits for the compositor rather than the main loop
+	std::atomic< bool > m_bPresentWaits{ false };
 	// A GDI+ token
 	static unsigned long long s_pGDIToken;
 };
@@ -1093,6 +1266,8 @@ public:
 	// Set the render target for all subsequent drawing operations
 	// Returns a pointer to any previous render target
 	PixelData* SetRenderTarget( PixelData* pRenderTarget ) { PixelData* old = m_pRenderTarget; m_pRenderTarget = pRenderTarget; return old; }
+	// Gets the current render target
+	const PixelData* GetRenderTarget( void ) const { return m_pRenderTarget; }
 
 	// Primitive drawing functions
 	//********************************************************************************************************************************
@@ -1103,18 +1278,92 @@ public:
 	void DrawLine( int startX, int startY, int endX, int endY, Pixel pix ) const;
 	// Draws pixel data to the render target using a direct copy
 	// > Setting alphaMultiply < 1 forces a less optimal rendering approach (~50% slower) 
-	void BlitPixels( const PixelData& srcImage, int srcOffset, int blitX, int blitY, int blitWidth, int blitHeight, float alphaMultiply ) const;
+	// > A tint other than white multiplies the colour of each source pixel as it is drawn
+	void BlitPixels( const PixelData& srcImage, int srcOffset, int blitX, int blitY, int blitWidth, int blitHeight, float alphaMultiply, Pixel tint = PIX_WHITE ) const;
 	// Draws rotated and scaled pixel data to the render target (much slower than BlitPixels)
 	// > Setting alphaMultiply < 1 is not much slower overall (~10% slower) 
-	void TransformPixels( const PixelData& srcPixelData, int srcFrameOffset, int srcWidth, int srcHeight, const Point2f& origin, const Matrix2D& m, float alphaMultiply = 1.0f ) const;
+	void TransformPixels( const PixelData& srcPixelData, int srcFrameOffset, int srcWidth, int srcHeight, const Point2f& origin, const Matrix2D& m, float alphaMultiply = 1.0f, Pixel tint = PIX_WHITE ) const;
 	// Clears the render target using the given pixel colour
 	void ClearRenderTarget( Pixel colour ) const;
 	// Copies a background image of the correct size to the render target
 	void BlitBackground( PixelData& backgroundImage ) const;
+	// Copies a background image of any size to the render target, offset by the scroll position and optionally wrapped around
+	// > Opaque images are copied a row at a time, while pre-multiplied images (with transparency) are blended with the render target
+	void BlitBackground( const PixelData& backgroundImage, int scrollX, int scrollY, bool tile ) const;
+	// Stretches an opaque image to fill a larger one (e.g. a frame drawn at a lower resolution to fill the display buffer)
+	// > Nearest neighbour repeats whole pixels (exactly doubling them at half size), while smooth blends the four nearest pixels
+	static void UpscalePixels( const PixelData& source, PixelData& dest, bool smooth );
+
+	// Draw list functions
+	//********************************************************************************************************************************
+
+	// A drawing operation recorded to be carried out later (by any thread)
+	struct DrawCommand
+	{
+		enum Operation : uint8_t
+		{
+			DRAW_PIXEL = 0,
+			DRAW_LINE,
+			BLIT_PIXELS,
+			TRANSFORM_PIXELS,
+			CLEAR,
+			BLIT_BACKGROUND,
+			BLIT_BACKGROUND_SCROLLED,
+		};
+
+		Operation operation{ DRAW_PIXEL };
+		PixelData source; // A copy of the image's details (the pixels themselves aren't copied)
+		int offset{ 0 }; // The offset of the frame in the source image
+		int x{ 0 }, y{ 0 }; // The position on the render target (or the scroll position for backgrounds)
+		int width{ 0 }, height{ 0 }; // The size of the area drawn (or the end point for lines)
+		float alpha{ 1.0f };
+		Pixel pix; // The colour or tint
+		Point2f origin{ 0.0f, 0.0f };
+		Matrix2D transform;
+		bool tile{ false };
+		int layer{ 0 }; // The draw layer and key of a command recorded in a thread's own list
+		uint32_t key{ 0 };
+	};
+
+	// Records the drawing operations aimed at the current render target into the list instead of carrying them out
+	// > Drawing to other render targets still happens straight away. Setting nullptr stops recording
+	void SetDrawList( std::vector< DrawCommand >* pDrawList ) { m_pDrawList = pDrawList; m_pDrawListTarget = m_pRenderTarget; }
+	// Carries out the drawing operations in a list on the render target, in the order they were recorded
+	// > If the blitter is recording, the operations are added to the list being recorded instead
+	void ExecuteDrawList( const std::vector< DrawCommand >& vDrawList ) const;
+	// Records all the drawing operations made by the calling thread into its own list instead, whatever the render target
+	// > The commands are tagged with the thread's draw layer and the key, so that lists from several threads can be merged in order
+	static void SetThreadDrawList( std::vector< DrawCommand >* pDrawList, uint32_t key ) { s_pThreadDrawList = pDrawList; s_threadDrawKey = key; }
+	// Sets the draw layer the calling thread's recorded commands are tagged with
+	static void SetThreadDrawLayer( int layer ) { s_threadDrawLayer = layer; }
+	// Gets the draw layer the calling thread's recorded commands are tagged with
+	static int GetThreadDrawLayer() { return s_threadDrawLayer; }
+	// Gets the calling thread's own draw list (nullptr if it isn't recording into one)
+	static std::vector< DrawCommand >* GetThreadDrawList() { return s_pThreadDrawList; }
 
 private:
 
+	// Checks whether drawing operations should be recorded into a draw list rather than carried out
+	bool IsRecording() const { return s_pThreadDrawList || ( m_pDrawList && m_pRenderTarget == m_pDrawListTarget ); }
+	// Adds a command to the calling thread's draw list if it has one, or to the blitter's
+	void Record( DrawCommand& command ) const;
+
+	// Blends a span of pre-multiplied background pixels with the render target, skipping any fully transparent runs
+	static void BlendBackgroundSpan( const Pixel* pSrc, Pixel* pDest, int count );
+
+	// Creates the multipliers used by TintPixel from a tint colour
+	static __m128i TintMultiplier( Pixel tint );
+	// Multiplies the colour channels of a pre-multiplied pixel by a tint, leaving the alpha untouched
+	static uint32_t TintPixel( uint32_t src, __m128i tintMul );
+
 	PixelData* m_pRenderTarget{ nullptr };
+	// The list which drawing operations are recorded into, and the render target they're recorded for
+	std::vector< DrawCommand >* m_pDrawList{ nullptr };
+	PixelData* m_pDrawListTarget{ nullptr };
+	// The calling thread's own draw list, and the key and layer its commands are tagged with
+	static thread_local std::vector< DrawCommand >* s_pThreadDrawList;
+	static thread_local uint32_t s_threadDrawKey;
+	static thread_local int s_threadDrawLayer;
 
 };
 
@@ -1163,6 +1412,7 @@ public:
 
 	// Draws a single character using the in-built debug font
 	// > Returns the character width in pixels
+	// > At a render scale below 1 it's drawn at full resolution over the frame once the frame has been stretched to fill the display buffer
 	int DrawDebugCharacter( Point2f pos, char c, Pixel pix );
 	// Draws text using the in-built debug font
 	// > Returns the x position at the end of the text
@@ -1181,9 +1431,13 @@ public:
 	// > Left to caller to release old PixelData
 	int UpdateSprite( const std::string& name, PixelData& pixelData, int hCount = 1, int vCount = 1 );
 	
-	// Loads a background image which is assumed to be the same size as the display buffer
+	// Loads a background image of any size
+	// > Images containing transparency are pre-multiplied so they can be blended over other background layers
+	// > Loading the same file again just returns the same index (each load must be matched by an UnloadBackground)
 	// > Returns the index of the loaded background
 	int LoadBackground( const char* fileAndPath );
+	// Releases a background image loaded with LoadBackground, freeing it when it isn't used by any other loads
+	void UnloadBackground( int backgroundId );
 
 	// Sprite Getters and Setters
 	//********************************************************************************************************************************
@@ -1218,15 +1472,26 @@ public:
 	// Draw the sprite without rotation or transparency (fastest draw)
 	inline void Draw( int spriteId, Point2f pos, int frameIndex ) const { DrawTransparent( spriteId, pos, frameIndex, 1.0f ); }
 	// Draw the sprite with transparency (slower than without transparency)
-	void DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply ) const; // This just to force people to consider when they use an explicit alpha multiply
+	// > The tint multiplies the sprite's colour for this draw only
+	void DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply, Pixel tint = PIX_WHITE ) const; // This just to force people to consider when they use an explicit alpha multiply
 	// Draw the sprite rotated with transparency (slowest draw)
-	void DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale = 1.0f, float alphaMultiply = 1.0f ) const;
+	void DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale = 1.0f, float alphaMultiply = 1.0f, Pixel tint = PIX_WHITE ) const;
 	// Draw the sprite using a matrix transformation and transparency (slowest draw)
-	void DrawTransformed( int spriteId, const Matrix2D& transform, int frameIndex, float alphaMultiply = 1.0f ) const;
+	void DrawTransformed( int spriteId, const Matrix2D& transform, int frameIndex, float alphaMultiply = 1.0f, Pixel tint = PIX_WHITE ) const;
 	// Draws a previously loaded background image
+	// > Replaces everything on the render target: anything the image doesn't cover (or shows through it) is cleared to black
 	void DrawBackground( int backgroundIndex = 0 );
+	// Adds a previously loaded background image as a parallax layer (layers are drawn in the order they are added)
+	// > The scroll factor scales the camera movement for the layer: 0 = fixed to the screen, 1 = moves with the world
+	// > Returns the index of the new layer
+	int AddBackgroundLayer( int backgroundIndex, float scrollFactor = 1.0f, bool tile = true );
+	// Removes all the background layers (the background images themselves stay loaded)
+	void ClearBackgroundLayers() { m_vBackgroundLayers.clear(); }
+	// Draws all the background layers scrolled relative to the given camera position
+	void DrawBackgroundLayers( Point2f cameraPos ) const;
 	// Multiplies the sprite image buffer by the colour values
 	// > Applies to all subseqent drawing calls for this sprite, but can be reset by calling agin with rgb set to white
+	// > Recalculates the whole sprite, so prefer the tint parameter of the drawing functions for per-draw colours
 	void ColourSprite( int spriteId, int r, int g, int b );
 
 	// Draws a string using a sprite-based font exported from PlayFontTool
@@ -1240,8 +1505,57 @@ public:
 	// Gets the width of an individual text character from a sprite-based font
 	int GetFontCharWidth( int fontId, char c ) const;
 
+	// Tilemap functions
+	//********************************************************************************************************************************
+
+	// Creates a tilemap of the given size where each tile is a frame from the given sprite sheet (e.g. "tiles_10x10.png")
+	// > All tiles start empty. Returns the id of the new tilemap
+	int CreateTilemap( int spriteId, int columns, int rows );
+	// Frees up a tilemap and its cached chunks
+	void DestroyTilemap( int tilemapId );
+	// Sets the frame of the sprite sheet used by a tile (-1 = empty)
+	// > Only the chunk containing the tile is rebuilt, the next time it is drawn
+	void SetTile( int tilemapId, int column, int row, int tileIndex );
+	// Gets the frame of the sprite sheet used by a tile (-1 = empty)
+	int GetTile( int tilemapId, int column, int row ) const;
+	// Sets a rectangular block of tiles from an array of sprite frames (one row after another)
+	// > Frames outside the sprite sheet are left empty (and assert)
+	void SetTiles( int tilemapId, int column, int row, int width, int height, const int16_t* pTiles );
+	// Sets a rectangular block of tiles to the same sprite frame (-1 = empty)
+	void FillTiles( int tilemapId, int column, int row, int width, int height, int tileIndex );
+	// Gets the size of a single tile in pixels
+	Vector2f GetTileSize( int tilemapId ) const;
+	// Draws the visible chunks of a tilemap with its top left corner at the given position
+	// > Chunks without any transparency are copied straight into the render target
+	void DrawTilemap( int tilemapId, Point2f pos );
+
+	// Render layer functions
+	//********************************************************************************************************************************
+
+	// Creates an offscreen layer for drawing things which rarely change into (e.g. HUD text), so they can be drawn with a single blit
+	// > Returns the id of the new layer, which starts off dirty
+	int CreateRenderLayer( int width, int height );
+	// Frees up a render layer's pixel data
+	void DestroyRenderLayer( int layerId );
+	// Marks a render layer as needing to be drawn again (e.g. when the score it shows has changed)
+	void SetRenderLayerDirty( int layerId );
+	// Checks whether a render layer needs to be drawn again
+	bool IsRenderLayerDirty( int layerId ) const;
+	// Starts drawing into a render layer: everything drawn until EndRenderLayer replaces what was in the layer before
+	// > Positions are relative to the layer's top left corner
+	void BeginRenderLayer( int layerId );
+	// Finishes drawing into the render layer and goes back to the previous render target
+	// > The drawing is done twice, over white and over black, to work out how transparent each pixel of the layer is
+	void EndRenderLayer();
+	// Blends a render layer (as it was last drawn) with the render target, with its top left corner at the given position
+	// > Runs of transparent pixels in the layer are skipped over
+	void DrawRenderLayer( int layerId, Point2f pos, float alphaMultiply = 1.0f );
+
 	// A pixel-based sprite collision test based on drawing
 	bool SpriteCollide( int s1Id, Point2f s1Pos, int s1FrameIndex, float s1Angle, int s1PixelColl[4], int s2Id, Point2f s2pos, int s2FrameIndex, float s2Angle, int s2PixelColl[4] ) const;
+	// A pixel-perfect collision test using the 1-bit collision masks made for each sprite frame when the sprite is added
+	// > The positions are the sprite origins (which are also the centres of rotation). Much faster than SpriteCollide, especially if the angles are the same
+	bool MaskCollide( int s1Id, Point2f s1Pos, int s1FrameIndex, float s1Angle, int s2Id, Point2f s2Pos, int s2FrameIndex, float s2Angle ) const;
 
 	// Internal sprite structure for storing individual sprite data
 	struct Sprite
@@ -1254,6 +1568,8 @@ public:
 		int originX{ 0 }, originY{ 0 }; // The origin and centre of rotation for the sprite (whole pixels only)
 		PixelData canvasBuffer; // The sprite image data
 		PixelData preMultAlpha; // The sprite data pre-multiplied with its own alpha
+		std::vector<uint64_t> vCollisionMask; // One bit per pixel (set unless the pixel is fully transparent) for each frame in turn
+		int maskStride{ 0 }; // The number of 64-bit words in each row of the collision mask
 		Sprite() = default;
 	};
 
@@ -1276,6 +1592,90 @@ public:
 	// Sets the render target for drawing operations
 	PixelData* SetRenderTarget( PixelData* renderTarget ) { return m_blitter.SetRenderTarget( renderTarget ); }
 
+	// Pipelined rendering functions
+	//********************************************************************************************************************************
+
+	// Turns pipelined rendering on or off
+	// > While it's on, the drawing functions record what they draw to the display buffer, and each frame is drawn on a render thread
+	//   while the game works on the next one, so a frame takes about as long as the slower of the two rather than both added together
+	// > The game mustn't read the display buffer's pixels while it's on
+	void SetPipelinedRendering( bool enable );
+	// Checks whether pipelined rendering is on
+	bool GetPipelinedRendering() const { return m_bPipelined; }
+	// Finishes the frame: draws it into the display buffer and then calls the present function (e.g. to copy it to the window)
+	// > With pipelined rendering the render thread does this while the next frame is recorded, after waiting for the frame before
+	void SubmitFrame( void ( *pPresent )( const PixelData& displayBuffer ) );
+	// Waits for the render thread to finish drawing the last frame submitted (e.g. before changing pixel data it might be reading)
+	void WaitForRender();
+	// Presents the last frame again (e.g. when the window has been uncovered but nothing has been drawn since)
+	void PresentLastFrame();
+	// Gets the time (in milliseconds) spent drawing the last frame on the render thread
+	float GetRenderTime() const { return m_renderTime.load(); }
+	// Gets the time (in milliseconds) from the last frame being submitted to it being presented
+	// > With pipelined rendering this is about one frame longer, as the frame waits for the one before it to be drawn
+	float GetPresentLatency() const { return m_presentLatency.load(); }
+
+	// Presenter thread functions
+	//********************************************************************************************************************************
+
+	// Turns the presenter thread on or off
+	// > While it's on, each finished frame is copied into one of three display buffers and the present function is called with it on
+	//   the presenter thread, so the game goes straight on to the next frame however long the present takes
+	// > If the presenter falls behind, the newest frame replaces the one waiting to be presented rather than the game waiting
+	void SetThreadedPresent( bool enable );
+	// Checks whether the presenter thread is on
+	bool GetThreadedPresent() const { return m_bThreadedPresent; }
+	// Gets the time (in milliseconds) the presenter thread spent in the present function for the last frame
+	float GetPresenterTime() const { return m_presenterTime.load(); }
+	// Gets the number of frames the presenter thread has presented
+	int GetFramesPresented() const { return m_framesPresented.load(); }
+	// Gets the number of frames which were replaced by a newer one before the presenter thread could present them
+	int GetFramesDropped() const { return m_framesDropped.load(); }
+
+	// Threaded drawing functions
+	//********************************************************************************************************************************
+
+	// Records the drawing done by the calling thread into a list of its own until EndThreadDrawing, so that several threads can draw at once
+	// > The key orders this thread's drawing against the other threads' within each layer (e.g. the index of the batch of work)
+	void BeginThreadDrawing( uint32_t key, int layer = 0 );
+	// Stops recording the calling thread's drawing
+	void EndThreadDrawing() { PlayBlitter::SetThreadDrawList( nullptr, 0 ); }
+	// Sets the layer for the drawing the calling thread records: lower layers are drawn first when the threads' drawing is merged
+	void SetDrawLayer( int layer ) { PlayBlitter::SetThreadDrawLayer( layer ); }
+	// Draws everything the threads have recorded, ordered by layer, then key, then the order it was recorded in
+	// > Call once the threads have finished drawing, e.g. after a ParallelFor. Anything left is drawn at the end of the frame
+	void FlushThreadDrawing();
+
+	// Dynamic resolution functions
+	//********************************************************************************************************************************
+
+	// The fractions of the display buffer's resolution that frames can be drawn at
+	// > Multiples of a quarter keep the edges of tilemap chunks on whole pixels
+	static constexpr float RENDER_SCALES[] = { 1.0f, 0.75f, 0.5f };
+	static constexpr int RENDER_SCALE_COUNT = 3;
+
+	// Draws each frame into a smaller buffer at the nearest of the RENDER_SCALES, which is stretched to fill the display buffer when presented
+	// > Drawing positions stay in display buffer pixels. Sprites, backgrounds, tilemaps and render layers are drawn from copies shrunk
+	//   to the same scale (made when a scale is first used), so most drawing is as fast as ever but covers fewer pixels
+	// > Takes effect straight away, so it should be changed between frames
+	void SetRenderScale( float scale );
+	// Gets the fraction of the display buffer's resolution frames are being drawn at
+	float GetRenderScale() const { return RENDER_SCALES[m_renderScaleIndex]; }
+	// Sets whether frames drawn at a lower resolution are stretched smoothly (bilinear) or with whole pixels (nearest neighbour)
+	void SetSmoothUpscaling( bool smooth ) { WaitForRender(); m_bSmoothUpscaling = smooth; }
+	// Checks whether frames drawn at a lower resolution are stretched smoothly
+	bool GetSmoothUpscaling() const { return m_bSmoothUpscaling; }
+	// Gets the time (in milliseconds) spent stretching the last frame to fill the display buffer
+	float GetUpscaleTime() const { return m_upscaleTime.load(); }
+	// Turns on the automatic choice of render scale, aiming to keep the time each frame takes within the budget (in milliseconds)
+	// > The scale drops as soon as frames take too long on average, and only rises again when the larger scale is expected to fit
+	void SetDynamicResolution( bool enable, float frameBudget );
+	// Checks whether the render scale is chosen automatically
+	bool GetDynamicResolution() const { return m_bDynamicResolution; }
+	// Tells the dynamic resolution controller how long the last frame took to update and draw (in milliseconds)
+	// > Call once per frame, between frames. Does nothing unless dynamic resolution is on
+	void UpdateDynamicResolution( float frameTime );
+
 
 
 private:
@@ -1298,6 +1698,13 @@ private:
 	// Multiplies the sprite image by its own alpha transparency values to save repeating this calculation on every draw
 	// > A colour multiplication can also be applied at this stage, which affects all subseqent drawing operations on the sprite
 	void PreMultiplyAlpha( Pixel* source, Pixel* dest, int width, int height, int maxSkipWidth, float alphaMultiply, Pixel colourMultiply );
+	// Shrinks a block of pixels with a box filter, so each new pixel is the average of the area of the pixels it covers
+	// > Pre-multiplied pixels are averaged as they are stored (transparent runs count as fully transparent) and their runs are counted again
+	static void ShrinkPixels( const Pixel* pSrc, int srcStride, int srcWidth, int srcHeight, Pixel* pDest, int destStride, int destWidth, int destHeight, bool preMultiplied );
+	// Packs the opacity of every frame of the sprite into its 1-bit collision mask
+	void BuildCollisionMask( Sprite& s );
+	// Gets 64 bits from a row of a collision mask starting at any bit (bits outside the row are clear)
+	static uint64_t GetMaskBits( const uint64_t* pRow, int stride, int firstBit );
 
 	// Count of the total number of sprites loaded
 	int m_nTotalSprites{ 0 };
@@ -1334,14 +1741,440 @@ private:
 
 	// A vector of all the loaded sprites
 	std::vector< Sprite > vSpriteData;
-	// A vector of all the loaded backgrounds
+	// A vector of all the loaded backgrounds (unloaded backgrounds have no pixel data and their slots are reused)
 	std::vector< PixelData > vBackgroundData;
+	// The number of loads for each background which haven't been unloaded yet
+	std::vector< int > m_vBackgroundRefCounts;
+	// A map of the loaded backgrounds indexed by their (normalised) file paths
+	std::map< std::string, int > m_backgroundPathMap;
+
+	// Internal structure for storing a parallax background layer
+	struct BackgroundLayer
+	{
+		int backgroundId{ -1 };
+		float scrollFactor{ 1.0f };
+		bool tile{ true };
+	};
+
+	// A vector of the background layers in drawing order
+	std::vector< BackgroundLayer > m_vBackgroundLayers;
+
+	// The number of tiles along each side of a tilemap chunk
+	static constexpr int TILEMAP_CHUNK_SIZE = 16;
+
+	// Internal structure for storing a pre-composited block of tiles
+	struct TilemapChunk
+	{
+		PixelData canvas; // The tile images copied together
+		PixelData preMultAlpha; // Only used when the chunk contains transparent pixels
+		bool opaque{ false };
+		bool empty{ false }; // Chunks without any tiles don't keep any pixel data
+		bool dirty{ true };
+		PixelData scaled; // A shrunk copy of the canvas (or pre-multiplied canvas) for drawing at a render scale below 1
+		int scaledIndex{ 0 }; // The render scale of the shrunk copy (0 if there isn't an up to date one)
+	};
+
+	// Internal structure for storing a tilemap
+	struct Tilemap
+	{
+		int spriteId{ -1 };
+		int columns{ 0 }, rows{ 0 };
+		int chunksX{ 0 }, chunksY{ 0 };
+		std::vector< int16_t > vTiles; // One sprite frame index per tile, -1 = empty
+		std::vector< TilemapChunk > vChunks;
+	};
+
+	// A vector of all the tilemaps (destroyed tilemaps are left with a sprite id of -1 so the other ids don't change)
+	std::vector< Tilemap > m_vTilemaps;
+
+	// Copies the tiles in a chunk into its canvas and works out whether it needs blending
+	void RebuildTilemapChunk( Tilemap& map, int chunkX, int chunkY );
+	// Frees up the pixel data for all the chunks in a tilemap and marks them as needing a rebuild
+	void FreeTilemapChunks( Tilemap& map );
+	// Marks all the chunks overlapping a rectangular block of tiles as needing a rebuild
+	void MarkTilemapChunksDirty( Tilemap& map, int column, int row, int width, int height );
+
+	// Internal structure for storing a render layer
+	struct RenderLayer
+	{
+		PixelData canvas; // Pre-multiplied, with each transparent pixel storing the number of transparent pixels which follow it
+		PixelData scaled; // A shrunk copy of the canvas for drawing at a render scale below 1
+		int scaledIndex{ 0 }; // The render scale of the shrunk copy (0 if there isn't an up to date one)
+		bool dirty{ true };
+	};
+
+	// A vector of all the render layers (destroyed layers are left without any pixel data so the other ids don't change)
+	std::vector< RenderLayer > m_vRenderLayers;
+	// The layer between BeginRenderLayer and EndRenderLayer, and the render target to go back to afterwards
+	int m_drawingLayer{ -1 };
+	PixelData* m_pLayerOldTarget{ nullptr };
+	// The drawing done between BeginRenderLayer and EndRenderLayer
+	std::vector< PlayBlitter::DrawCommand > m_vLayerCommands;
+	// The layer drawn over white, to compare with the layer drawn over black
+	std::vector< Pixel > m_vLayerOverWhite;
+
+	// Works out the transparency of a layer drawn over black by comparing it with the same drawing over white, and pre-multiplies it
+	void EncodeRenderLayer( PixelData& canvas, const Pixel* pOverWhite );
+
+	// Gets the buffer frames are drawn into: the display buffer, or the smaller scaled buffer at a render scale below 1
+	PixelData& GetFrameBuffer() { return m_renderScaleIndex ? m_scaledBuffer : m_playBuffer; }
+	// Gets the scale drawing positions are multiplied by: the render scale while drawing into the scaled buffer, or 1 for anything else
+	float GetDrawScale() const { return m_blitter.GetRenderTarget() == &m_scaledBuffer ? RENDER_SCALES[m_renderScaleIndex] : 1.0f; }
+	// Makes a shrunk copy of a sprite for one of the render scales
+	void ScaleSprite( int spriteId, int scaleIndex );
+	// Frees up all the shrunk copies of a sprite, and makes a new one for the current render scale
+	void RescaleSprite( int spriteId );
+	// Makes a shrunk copy of a background for the current render scale, unless it already has one
+	void ScaleBackground( int backgroundId );
+	// Makes a shrunk copy of a pixel buffer for the current render scale, reusing the copy's memory if it's the right size
+	void ScalePixelData( const PixelData& source, PixelData& scaled );
+
+	// The current render scale (an index into RENDER_SCALES)
+	int m_renderScaleIndex{ 0 };
+	bool m_bSmoothUpscaling{ false };
+	// The buffer frames are drawn into at a render scale below 1 (allocated at the size of the largest scale, and shrunk for the others)
+	PixelData m_scaledBuffer;
+	// Shrunk copies of all the sprites for each render scale (kept after the scale changes so going back to it is quick)
+	std::vector< PixelData > m_vScaledSprites[RENDER_SCALE_COUNT];
+	// Shrunk copies of the backgrounds for each render scale (kept after the scale changes, like the sprites')
+	std::vector< PixelData > m_vScaledBackgrounds[RENDER_SCALE_COUNT];
+	std::atomic< float > m_upscaleTime{ 0.0f };
+
+	// The dynamic resolution controller moves between render scales to keep the average frame time within the budget
+	static constexpr float DYNAMIC_RESOLUTION_SMOOTHING = 0.1f; // How much each frame moves the average frame time
+	static constexpr float DYNAMIC_RESOLUTION_LOWER = 0.9f; // The fraction of the budget above which the scale drops
+	static constexpr float DYNAMIC_RESOLUTION_RAISE = 0.8f; // The fraction of the budget the larger scale is expected to fit in before it rises
+	static constexpr int DYNAMIC_RESOLUTION_SETTLE_FRAMES = 30; // How long the average is left to settle after the scale changes
+	bool m_bDynamicResolution{ false };
+	float m_frameBudget{ 0.0f };
+	float m_frameTimeAverage{ 0.0f };
+	int m_settleFrames{ 0 };
+
+	// The main loop of the render thread: draws and presents each frame as it's submitted
+	void RenderThreadLoop();
+
+	// Pipelined rendering records each frame into one list while the render thread draws the other
+	bool m_bPipelined{ false };
+	std::vector< PlayBlitter::DrawCommand > m_vDrawLists[2];
+	int m_recordList{ 0 };
+	std::thread m_renderThread;
+	std::mutex m_renderMutex;
+	std::condition_variable m_renderCondition;
+	bool m_bFrameSubmitted{ false }; // Set when a frame is handed to the render thread, and cleared when it has been presented
+	bool m_bRenderQuit{ false };
+	void ( *m_pPresent )( const PixelData& ) { nullptr };
+	std::chrono::steady_clock::time_point m_submitTime;
+	std::atomic< float > m_renderTime{ 0.0f };
+	std::atomic< float > m_presentLatency{ 0.0f };
+
+	// A debug font character drawn at a render scale below 1, waiting to be drawn over the frame at full resolution
+	struct DebugCharacter
+	{
+		Point2f pos;
+		char c;
+		Pixel pix;
+	};
+	// The characters waiting for each of the pipelined draw lists (the recording list's is used without pipelined rendering)
+	std::vector< DebugCharacter > m_vDebugCharacters[2];
+
+	// Presents the finished display buffer with the debug characters drawn over it, or hands a copy of it to the presenter thread
+	void PresentFrame( std::chrono::steady_clock::time_point submitTime, const std::vector< DebugCharacter >& vDebugCharacters );
+	// Draws debug characters into a buffer the size of the display buffer
+	void DrawDebugCharacters( PixelData& dest, const std::vector< DebugCharacter >& vDebugCharacters ) const;
+	// Stretches a frame drawn into the scaled buffer to fill the display buffer (or a presenter buffer)
+	void UpscaleFrame( PixelData& dest );
+	// The main loop of the presenter thread: presents the newest finished frame whenever there is one
+	void PresenterThreadLoop();
+
+	// The presenter thread presents one buffer while another holds the newest finished frame, so the third is always free to copy into
+	static constexpr int PRESENT_BUFFER_COUNT = 3;
+	bool m_bThreadedPresent{ false };
+	PixelData m_presentBuffers[PRESENT_BUFFER_COUNT];
+	std::chrono::steady_clock::time_point m_presentSubmitTimes[PRESENT_BUFFER_COUNT];
+	int m_readyBuffer{ -1 }; // The newest finished frame, waiting to be presented
+	int m_presentingBuffer{ -1 }; // The frame being presented
+	int m_presentedBuffer{ -1 }; // The last frame which was presented
+	void ( *m_pPresenterFunction )( const PixelData& ) { nullptr };
+	std::thread m_presentThread;
+	std::mutex m_presentMutex;
+	std::condition_variable m_presentCondition;
+	bool m_bPresentQuit{ false };
+	std::atomic< float > m_presenterTime{ 0.0f };
+	std::atomic< int > m_framesPresented{ 0 };
+	std::atomic< int > m_framesDropped{ 0 };
+
+	// The lists recorded by each thread which has used BeginThreadDrawing (a deque so they never move)
+	std::deque< std::vector< PlayBlitter::DrawCommand > > m_threadDrawLists;
+	std::mutex m_threadDrawMutex;
+	std::vector< PlayBlitter::DrawCommand > m_mergedDrawList;
+	// Tells the threads' drawing lists for different instances apart
+	int m_instanceNumber{ 0 };
+	static int s_instanceCount;
 
 	// A pointer to the static instance
 	static PlayGraphics* s_pInstance;
 
 };
 
+#endif
+#ifndef PLAY_PLAYSTREAMER_H
+#define PLAY_PLAYSTREAMER_H
+//********************************************************************************************************************************
+// File:		PlayStreamer.h
+// Description:	Streams a large tilemap level from disk in chunks around the camera
+// Platform:	Independent
+// Notes:		Chunk files are loaded and decoded on a separate I/O thread, so the game thread only has to copy the tiles in
+//				Each chunk is a text file called "<column>_<row>.txt" containing its tile indices (-1 = empty)
+//********************************************************************************************************************************
+
+// Streams a tilemap level from disk in chunks around a focus point
+// > A singleton class accessed using PlayStreamer::Instance()
+class PlayStreamer
+{
+public:
+	// Instance access functions 
+	//********************************************************************************************************************************
+
+	// Creates / Returns the PlayStreamer instance
+	static PlayStreamer& Instance();
+	// Destroys the PlayStreamer instance (if it exists) and stops the I/O thread
+	static void Destroy();
+
+	// Level streaming functions
+	//********************************************************************************************************************************
+
+	// Starts streaming a level from the chunk files in the given directory, closing any previous level
+	// > The level is a tilemap of the given size, split into square chunks of chunkSize tiles
+	// > Returns the id of the tilemap which the chunks are streamed into
+	int OpenLevel( const char* path, int tileSpriteId, int columns, int rows, int chunkSize );
+	// Stops streaming the current level and destroys its tilemap
+	void CloseLevel();
+	// Requests the chunks near the focus point (nearest first), unloads the distant ones and copies in the chunks which have
+	// finished loading, up to the per-frame budget
+	void Update( Point2f focus );
+	// Sets the distance (in pixels) from the focus point within which chunks are loaded, and beyond which they are unloaded
+	// > The unload radius should be larger than the load radius so chunks don't repeatedly load and unload at the boundary
+	void SetRadius( float loadRadius, float unloadRadius );
+	// Sets the maximum number of loaded chunks copied into the tilemap each frame
+	void SetBudget( int chunksPerFrame ) { m_budget = std::max( chunksPerFrame, 1 ); }
+	// Gets the number of chunks currently loaded into the tilemap
+	int GetLoadedChunkCount() const { return m_loadedCount; }
+	// Gets the number of chunks which have been requested but haven't been copied in yet
+	int GetPendingChunkCount() const { return m_pendingCount; }
+	// Gets the number of chunks in the current level whose files were missing, which are streamed in empty
+	// > Each one is also reported in the debugger's output window
+	int GetMissingChunkCount() const { return m_missingCount; }
+
+private:
+	// Constructor and destructor
+	//********************************************************************************************************************************
+
+	// Creates the streamer and starts the I/O thread
+	PlayStreamer();
+	// Stops the I/O thread and frees up any chunks it has loaded
+	~PlayStreamer();
+	// The assignment operator is removed to prevent copying of a singleton class
+	PlayStreamer& operator=( const PlayStreamer& ) = delete;
+	// The copy operator is removed to prevent copying of a singleton class
+	PlayStreamer( const PlayStreamer& ) = delete;
+
+	// The state of each chunk from the game thread's point of view
+	enum ChunkState : uint8_t
+	{
+		CHUNK_UNLOADED = 0,
+		CHUNK_REQUESTED,
+		CHUNK_LOADED,
+	};
+
+	// A chunk which the game thread wants the I/O thread to load
+	struct ChunkRequest
+	{
+		int chunkX{ 0 }, chunkY{ 0 };
+		int levelId{ 0 };
+		int tileCount{ 0 }; // The number of frames in the level's tile sprite sheet
+		std::string path;
+	};
+
+	// A chunk which the I/O thread has loaded and decoded
+	struct ChunkData
+	{
+		int chunkX{ 0 }, chunkY{ 0 };
+		int levelId{ 0 };
+		std::vector< int16_t > vTiles;
+		bool missing{ false }; // The chunk's file couldn't be opened
+		int invalidCount{ 0 }; // The number of tiles which were outside the sprite sheet (and left empty)
+		std::string path;
+	};
+
+	// The main loop of the I/O thread: takes the nearest request, loads it and passes it back
+	void IOThreadLoop();
+	// Reads a chunk file and decodes it into tile indices (missing tiles and ones outside the sprite sheet are left empty)
+	// > Returns false if the file couldn't be opened, leaving the whole chunk empty
+	bool LoadChunk( const ChunkRequest& request, ChunkData& chunk ) const;
+	// Gets the size of a chunk in tiles (the chunks along the right and bottom edges can be smaller)
+	void GetChunkTiles( int chunkX, int chunkY, int& column, int& row, int& width, int& height ) const;
+	// Gets the distance from the focus point to the centre of a chunk
+	float GetChunkDistance( int chunkX, int chunkY, Point2f focus ) const;
+
+	// The number of loaded chunks the I/O thread can hand over before waiting for the game thread
+	static constexpr int RING_SIZE = 64;
+
+	// The current level
+	std::string m_path;
+	int m_tilemapId{ -1 };
+	int m_columns{ 0 }, m_rows{ 0 };
+	int m_chunkSize{ 16 };
+	int m_chunksX{ 0 }, m_chunksY{ 0 };
+	Vector2f m_tileSize{ 0.0f, 0.0f };
+	int m_tileCount{ 0 };
+	std::vector< ChunkState > m_vChunkStates;
+	int m_levelId{ 0 }; // Identifies chunks which were loaded for a level which has since been closed
+
+	// Streaming settings and stats
+	float m_loadRadius{ 1000.0f };
+	float m_unloadRadius{ 1500.0f };
+	int m_budget{ 2 };
+	int m_loadedCount{ 0 };
+	int m_pendingCount{ 0 };
+	int m_missingCount{ 0 };
+
+	// Requests are re-sorted every frame so they're protected by a mutex, which the I/O thread sleeps on when there's no work
+	std::mutex m_requestMutex;
+	std::condition_variable m_requestCondition;
+	std::deque< ChunkRequest > m_requests;
+	bool m_bQuit{ false };
+
+	// Loaded chunks are passed back through a single-producer single-consumer ring so the game thread never waits for a lock
+	ChunkData* m_ring[RING_SIZE]{};
+	std::atomic< int > m_ringHead{ 0 }; // Next slot the I/O thread writes to
+	std::atomic< int > m_ringTail{ 0 }; // Next slot the game thread reads from
+
+	std::thread m_ioThread;
+
+	// Pointer to the singleton
+	static PlayStreamer* s_pInstance;
+};
+
+#endif
+#ifndef PLAY_PLAYJOBSYSTEM_H
+#define PLAY_PLAYJOBSYSTEM_H
+//********************************************************************************************************************************
+// File:		PlayJobSystem.h
+// Description:	A pool of worker threads which share out small jobs by stealing them from each other's queues
+// Platform:	Independent
+// Notes:		Each thread pushes and pops jobs at the back of its own queue and steals from the front of the others, so
+//				threads rarely touch the same end of a queue. Waiting threads run other jobs instead of blocking
+//********************************************************************************************************************************
+
+// Runs jobs on a pool of worker threads (one per core, with the thread which created the pool as one of them)
+// > A singleton class accessed using PlayJobSystem::Instance()
+class PlayJobSystem
+{
+public:
+	// Counts the unfinished jobs started with it, so the thread which started them can wait for them all to finish
+	// > Jobs can start child jobs on a counter of their own and wait for those before they finish themselves
+	struct JobCounter
+	{
+		std::atomic< int > count{ 0 };
+	};
+
+	// The function called to run a job, which is given a range of indices when it is part of a ParallelFor
+	typedef void ( *JobFunction )( void* pData, int begin, int end );
+
+	// Instance access functions 
+	//********************************************************************************************************************************
+
+	// Creates the PlayJobSystem instance with the given total number of threads (0 for one per core)
+	// > The calling thread counts as one of them, and only it and the worker threads can start jobs
+	static PlayJobSystem& Instance( int threadCount );
+	// Returns the PlayJobSystem instance (creating it with one thread per core if it doesn't exist)
+	static PlayJobSystem& Instance();
+	// Destroys the PlayJobSystem instance (if it exists) and stops the worker threads
+	static void Destroy();
+
+	// Job functions
+	//********************************************************************************************************************************
+
+	// Starts a job which calls the function with pData, adding it to the counter
+	void Run( JobCounter& counter, JobFunction pFunction, void* pData, int begin = 0, int end = 0 );
+	// Runs other jobs until all the jobs started with the counter have finished
+	void Wait( JobCounter& counter );
+	// Calls the function for ranges of indices from 0 to count, spread over all the threads, and returns when they're all done
+	// > Each call is given at most grainSize indices (0 picks a size which gives each thread a few ranges)
+	void ParallelFor( int count, JobFunction pFunction, void* pData, int grainSize = 0 );
+	// Calls the function (e.g. a lambda taking the beginning and end of a range) for ranges of indices from 0 to count
+	template< typename Function >
+	void ParallelFor( int count, Function function, int grainSize = 0 )
+	{
+		ParallelFor( count, []( void* pData, int begin, int end ) { ( *static_cast<Function*>( pData ) )( begin, end ); }, &function, grainSize );
+	}
+	// Gets the total number of threads which run jobs (including the one which created the pool)
+	int GetThreadCount() const { return static_cast<int>( m_vQueues.size() ); }
+
+private:
+	// Constructor and destructor
+	//********************************************************************************************************************************
+
+	// Creates the queues and starts the worker threads
+	PlayJobSystem( int threadCount );
+	// Stops the worker threads once they have finished their jobs
+	~PlayJobSystem();
+	// The assignment operator is removed to prevent copying of a singleton class
+	PlayJobSystem& operator=( const PlayJobSystem& ) = delete;
+	// The copy operator is removed to prevent copying of a singleton class
+	PlayJobSystem( const PlayJobSystem& ) = delete;
+
+	// A job waiting to be run
+	struct Job
+	{
+		JobFunction pFunction{ nullptr };
+		void* pData{ nullptr };
+		int begin{ 0 }, end{ 0 };
+		JobCounter* pCounter{ nullptr };
+	};
+
+	// A fixed-size work-stealing deque: only its owner pushes and pops at the back, but any thread can steal from the front
+	struct JobQueue
+	{
+		static constexpr int CAPACITY = 4096; // Must be a power of 2
+
+		// Adds a job to the back (owner only)
+		// > Returns false if the queue is full
+		bool Push( const Job& job );
+		// Takes the most recently pushed job from the back (owner only)
+		bool Pop( Job& job );
+		// Takes the oldest job from the front (any thread)
+		bool Steal( Job& job );
+
+		Job jobs[CAPACITY];
+		std::atomic< int64_t > top{ 0 };
+		std::atomic< int64_t > bottom{ 0 };
+	};
+
+	// The main loop of each worker thread: runs jobs when there are any and sleeps when there aren't
+	void WorkerLoop( int threadIndex );
+	// Takes a job from the thread's own queue, or steals one from another thread's
+	bool FindJob( int threadIndex, Job& job );
+	// Runs a job and counts it off
+	void Execute( const Job& job );
+
+	// Queues are allocated separately so they don't share cache lines
+	std::vector< JobQueue* > m_vQueues;
+	std::vector< std::thread > m_vThreads;
+
+	// Idle workers sleep until there are jobs waiting again
+	std::atomic< int > m_pendingJobs{ 0 };
+	std::atomic< int > m_sleepingThreads{ 0 };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeCondition;
+	bool m_bQuit{ false };
+
+	// The index of the calling thread's queue (-1 for threads which aren't part of the pool)
+	static thread_local int s_threadIndex;
+	// Pointer to the singleton
+	static PlayJobSystem* s_pInstance;
+};
+
 #endif
 #ifndef PLAY_PLAYAUDIO_H
 #define PLAY_PLAYAUDIO_H
@@ -1486,7 +2319,6 @@ struct GameObject
 	GameObject( int type, Point2D pos, int collisionRadius, int spriteId );
 
 	// Default member variables: don't change these!
-	int type{ -1 };
 	int oldType{ -1 };
 	int spriteId{ -1 };
 	Point2D pos{ 0.0f, 0.0f };
@@ -1502,21 +2334,83 @@ struct GameObject
 	int radius{ 0 };
 	float scale{ 1 };
 	int lastFrameUpdated{ -1 };
+	int collisionLayer{ 0 }; // 0-31, see Play::SetLayerCollision
+	unsigned int collisionMask{ 0xFFFFFFFF }; // Bit n is set if the object can collide with layer n
+	int updateInterval{ 1 }; // Only moved every Nth frame (by N frames' worth) by Play::UpdateGameObject
+	bool asleep{ false }; // Not moved at all by Play::UpdateGameObject until woken up
 
 	// Add your own data members here if you want to
 	PLAY_ADD_GAMEOBJECT_MEMBERS
 
 	int GetId() { return m_id; }
+	// Use Play::SetGameObjectType to change the type
+	int GetType() const { return m_type; }
 
 private:
 	// The GameObject's id should never be changed manually so we make it private!
 	int m_id{ -1 };
+	// The type is private so that every change goes through the manager, which keeps a list of the objects of each type
+	int m_type{ -1 };
 
 	// Preventing assignment and copying reduces the potential for bugs
-	GameObject& operator=( const GameObject& ) = delete;
+	// > The GameObjectPool which stores the objects is allowed to create empty objects and reuse them
+	friend class GameObjectPool;
+	friend class GameObjectCommands;
+	GameObject() = default;
+	GameObject& operator=( const GameObject& ) = default;
 	GameObject( const GameObject& ) = delete;
 };
 
+// Collects the changes which Play::ParallelUpdateGameObjects' function can't make straight away, because other threads are
+// using the GameObjects at the same time
+// > The changes are made after all the objects have been updated, in the same order as if they'd been updated one at a time
+class GameObjectCommands
+{
+public:
+	GameObjectCommands() = default;
+	// Frees up the objects waiting to be created
+	~GameObjectCommands();
+
+	// Creates a new GameObject after the update
+	// > Returns the new object so it can be set up, but it doesn't have an id until it's actually created
+	GameObject& CreateGameObject( int type, Point2D pos, int collisionRadius, const char* spriteName );
+	// Deletes the GameObject with the corresponding id after the update
+	void DestroyGameObject( int id );
+	// Changes the type of a GameObject after the update
+	void SetGameObjectType( GameObject& obj, int type );
+	// Plays an mp3 audio file from the "Data\Sounds" directory after the update
+	void PlayAudio( const char* mp3Filename );
+	// Makes all the changes in the order they were added, then empties the list
+	void Apply();
+
+private:
+	// The assignment operator is removed as the commands own the objects waiting to be created
+	GameObjectCommands& operator=( const GameObjectCommands& ) = delete;
+	// The copy operator is removed as the commands own the objects waiting to be created
+	GameObjectCommands( const GameObjectCommands& ) = delete;
+
+	enum CommandType
+	{
+		COMMAND_CREATE = 0,
+		COMMAND_DESTROY,
+		COMMAND_SET_TYPE,
+		COMMAND_PLAY_AUDIO,
+	};
+
+	struct Command
+	{
+		CommandType command;
+		int id; // The object's id, or the index of the object to create in m_vCreated
+		int type;
+		std::string audio;
+	};
+
+	std::vector< Command > m_vCommands;
+	// Objects waiting to be created (reused, so only the first m_createdCount are in use)
+	std::vector< GameObject* > m_vCreated;
+	int m_createdCount{ 0 };
+};
+
 #endif
 
 namespace Play
@@ -1542,6 +2436,21 @@ namespace Play
 		SCREEN,
 	};
 
+	enum CollisionState
+	{
+		COLLISION_ENTER = 0,
+		COLLISION_STAY,
+		COLLISION_EXIT,
+	};
+
+	// A pair of GameObjects found by Play::UpdateCollisions
+	struct CollisionPair
+	{
+		int idA;
+		int idB;
+		CollisionState state;
+	};
+
 	// PlayManager uses colour values from 0-100 for red, green, blue and alpha
 	struct Colour
 	{
@@ -1565,6 +2474,36 @@ namespace Play
 
 	// Copies the contents of the drawing buffer to the window
 	void PresentDrawingBuffer();
+	// Moves on to the next frame without drawing or presenting anything, leaving the last frame presented in the window
+	// > Call it instead of clearing, drawing and PresentDrawingBuffer on screens which haven't changed since the last frame
+	// > The next frame then waits for input (or a tenth of a second) instead of running on time
+	// > If Windows has asked for the window to be repainted (e.g. after it was uncovered), the last frame is presented again
+	void MarkFrameUnchanged();
+	// Sets the layer for drawing done inside ParallelUpdateGameObjects: lower layers are drawn first
+	// > The layers only order the drawing within one ParallelUpdateGameObjects call, which is all drawn when the call returns
+	// > Drawing outside ParallelUpdateGameObjects ignores the layer and happens straight away
+	void SetDrawLayer( int layer );
+	// Draws each frame on a render thread while the game updates the next one (see PlayGraphics::SetPipelinedRendering)
+	// > Adds about a frame of latency, which is shown with the F1 debug info
+	void SetPipelinedRendering( bool enable );
+	// Gets the time in milliseconds from the last frame being presented to it reaching the window
+	float GetPresentLatency();
+	// Copies each finished frame to the window on a presenter thread, so the game never waits for the compositor
+	// > See PlayGraphics::SetThreadedPresent. The presenter's timings are shown with the F1 debug info
+	void SetThreadedPresent( bool enable );
+	// Sets the number of frames per second the game runs at, e.g. 30, 60, 120 or 144 (0 to run as fast as it can)
+	// > The frame timings and jitter are shown with the F1 debug info
+	void SetTargetFrameRate( int framesPerSecond );
+	// Draws each frame at a fraction of the display buffer's resolution (1, 0.75 or 0.5) and stretches it to fill the window
+	// > See PlayGraphics::SetRenderScale. The scale and the time spent stretching are shown with the F1 debug info
+	void SetRenderScale( float scale );
+	// Gets the fraction of the display buffer's resolution frames are being drawn at
+	float GetRenderScale();
+	// Lowers the render scale automatically when frames take longer than the target frame rate allows, and raises it when they'd fit again
+	// > Turning it off leaves the render scale where it is
+	void SetDynamicResolution( bool enable );
+	// Sets whether frames drawn at a lower resolution are stretched smoothly (bilinear) rather than with whole pixels
+	void SetSmoothUpscaling( bool smooth );
 	// Gets the co-ordinates of the mouse cursor within the display buffer
 	Point2D GetMousePos();
 	// Gets the status of the left or right mouse buttons
@@ -1596,6 +2535,34 @@ namespace Play
 	// Get the current drawing space setting
 	DrawingSpace GetDrawingSpace( void );
 
+	// Fixed timestep functions
+	//**************************************************************************************************
+
+	// Runs the simulation at a fixed number of ticks per second, independently of how often frames are drawn (0 turns it off)
+	// > While it is on, the DrawObject functions draw GameObjects part of the way between their old and new positions
+	void SetFixedTimestep( int ticksPerSecond );
+	// Adds the frame's elapsed time to the simulation and returns true while there is a whole tick left to run
+	// > Put the game's update code in a loop: while( Play::FixedUpdateStep( elapsedTime ) ) { ... }
+	// > Returns true exactly once per frame when the fixed timestep is turned off
+	bool FixedUpdateStep( float elapsedTime );
+	// Gets the length of one simulation tick in seconds (a frame at the target frame rate when the fixed timestep is off)
+	float GetSimulationTimestep();
+	// Gets how far the simulation is between the last tick and the next one, from 0 to 1
+	// > Always 1 when the fixed timestep is off
+	float GetInterpolationAlpha();
+
+	// Job system functions
+	//**************************************************************************************************
+
+	// Calls the function (e.g. a lambda taking the beginning and end of a range) for ranges of indices from 0 to count,
+	// spread over all the cores, and returns when they're all done
+	// > Each call is given at most grainSize indices (0 picks a size which gives each core a few ranges)
+	template< typename Function >
+	void ParallelFor( int count, Function function, int grainSize = 0 )
+	{
+		PlayJobSystem::Instance().ParallelFor( count, function, grainSize );
+	}
+
 	
 	// PlayGraphics functions
 	//**************************************************************************************************
@@ -1603,12 +2570,70 @@ namespace Play
 	// Clears the display buffer using the colour provided
 	void ClearDrawingBuffer( Colour col );
 	// Loads a PNG file as the background image for the window
+	// > Loading a file which is already loaded costs nothing and returns the same background
 	int LoadBackground( const char* pngFilename );
+	// Releases a background loaded with Play::LoadBackground(), freeing its memory once every load of it has been released
+	void UnloadBackground( int background );
 	// Draws the background image previously loaded with Play::LoadBackground() into the drawing buffer
 	void DrawBackground( int background = 0 );
+	// Adds a background image previously loaded with Play::LoadBackground() as a parallax layer
+	// > The scroll factor scales the camera movement for the layer: 0 = fixed to the screen, 1 = moves with the world
+	// > Tiled layers wrap around in both directions so they never run out
+	int AddBackgroundLayer( int background, float scrollFactor = 1.0f, bool tile = true );
+	// Removes all the background layers
+	void ClearBackgroundLayers( void );
+	// Draws all the background layers into the drawing buffer, scrolled relative to the camera position
+	// > Opaque layers are copied, layers with transparency are blended over the layers behind them
+	void DrawBackgroundLayers( void );
 	// Draws text to the screen using the built-in debug font
 	void DrawDebugText( Point2D pos, const char* text, Colour col = cWhite, bool centred = true );
 
+	// Creates a tilemap of empty tiles which uses the frames of a sprite sheet as its tiles (e.g. "tiles_10x10.png")
+	// > Returns the id of the new tilemap
+	int CreateTilemap( const char* spriteName, int columns, int rows );
+	// Frees up a tilemap created with Play::CreateTilemap()
+	void DestroyTilemap( int tilemap );
+	// Sets the sprite frame used by an individual tile (-1 = empty)
+	void SetTile( int tilemap, int column, int row, int tile );
+	// Gets the sprite frame used by an individual tile (-1 = empty or outside the tilemap)
+	int GetTile( int tilemap, int column, int row );
+	// Draws a tilemap into the drawing buffer with its top left corner at the given position
+	// > The tiles are cached in large chunks, so this is much faster than drawing each tile as a sprite
+	void DrawTilemap( int tilemap, Point2D pos = { 0.0f, 0.0f } );
+
+	// Creates an offscreen layer for drawing things which rarely change into (e.g. HUD text), so they can be drawn with one blit
+	// > Returns the id of the new layer, which starts off dirty
+	int CreateRenderLayer( int width, int height );
+	// Frees up a render layer created with Play::CreateRenderLayer()
+	void DestroyRenderLayer( int layer );
+	// Marks a render layer as needing to be drawn again (e.g. when the score it shows has changed)
+	void SetRenderLayerDirty( int layer );
+	// Checks whether a render layer needs to be drawn again
+	bool IsRenderLayerDirty( int layer );
+	// Starts drawing into a render layer instead of the drawing buffer, with positions relative to the layer's top left corner
+	void BeginRenderLayer( int layer );
+	// Finishes drawing into a render layer and goes back to drawing into the drawing buffer
+	void EndRenderLayer( void );
+	// Draws a render layer into the drawing buffer with its top left corner at the given position
+	void DrawRenderLayer( int layer, Point2D pos = { 0.0f, 0.0f }, float opacity = 1.0f );
+
+	// PlayStreamer functions
+	//**************************************************************************************************
+
+	// Starts streaming a tilemap level from a directory of chunk files called "<column>_<row>.txt"
+	// > Each file contains the tile indices for a square of chunkSize tiles (-1 = empty)
+	// > Returns a tilemap id which can be drawn with Play::DrawTilemap() at the world origin
+	int OpenStreamingLevel( const char* levelPath, const char* tileSprite, int columns, int rows, int chunkSize = 16 );
+	// Stops streaming the current level and destroys its tilemap
+	void CloseStreamingLevel( void );
+	// Loads and unloads the level chunks around the centre of the screen (call once per frame)
+	// > Chunks are loaded on a separate thread, so this never waits for the disk
+	void UpdateStreamingLevel( void );
+	// Sets the distances (in pixels) from the centre of the screen within which chunks are loaded and beyond which they are unloaded
+	void SetStreamingRadius( float loadRadius, float unloadRadius );
+	// Sets the maximum number of loaded chunks copied into the level each frame
+	void SetStreamingBudget( int chunksPerFrame );
+
 	// Gets the sprite id of the first matching sprite whose filename contains the given text
 	int GetSpriteId( const char* spriteName );
 	// Gets the pixel height of a sprite
@@ -1625,6 +2650,7 @@ namespace Play
 	int GetSpriteFrames( int spriteId );
 	// Blends the sprite with the given colour (works best on white sprites)
 	// > Note that colouring affects subsequent DrawSprite calls using the same sprite!!
+	// > Use the tint parameter on DrawSpriteTransparent / DrawSpriteRotated to colour a single draw instead
 	void ColourSprite( const char* spriteName, Colour col );
 
 	// Centres the origin of the first sprite found matching the given name
@@ -1655,29 +2681,31 @@ namespace Play
 	// Draws the sprite using its unique sprite ID
 	void DrawSprite( int spriteID, Point2D pos, int frame );
 	// Draws the sprite with transparency (slower than DrawSprite)
-	void DrawSpriteTransparent( const char* spriteName, Point2D pos, int frame, float opacity );
+	// > The tint colour multiplies the sprite's colour for this draw only (works best on white sprites)
+	void DrawSpriteTransparent( const char* spriteName, Point2D pos, int frame, float opacity, Colour tint = cWhite );
 	// Draws the sprite with transparency (slower than DrawSprite)
-	void DrawSpriteTransparent( int spriteID, Point2D pos, int frame, float opacity );
+	// > The tint colour multiplies the sprite's colour for this draw only (works best on white sprites)
+	void DrawSpriteTransparent( int spriteID, Point2D pos, int frame, float opacity, Colour tint = cWhite );
 	// Draws the sprite with rotation and transparency (slowest DrawSprite)
-	void DrawSpriteRotated( const char* spriteName, Point2D pos, int frame, float angle, float scale = 1.0f, float opacity = 1.0f );
+	void DrawSpriteRotated( const char* spriteName, Point2D pos, int frame, float angle, float scale = 1.0f, float opacity = 1.0f, Colour tint = cWhite );
 	// Draws the sprite with rotation and transparency (slowest DrawSprite)
-	void DrawSpriteRotated( int spriteID, Point2D pos, int frame, float angle, float scale, float opacity = 1.0f );
+	void DrawSpriteRotated( int spriteID, Point2D pos, int frame, float angle, float scale, float opacity = 1.0f, Colour tint = cWhite );
 	// Draws the sprite using a tranformation matrix. Final rendering approach depends on the contents of the matrix
-	void DrawSpriteTransformed( int spriteID, const Matrix2D& transform, int frame, float opacity = 1.0f );
+	void DrawSpriteTransformed( int spriteID, const Matrix2D& transform, int frame, float opacity = 1.0f, Colour tint = cWhite );
 	// Draws a single-pixel wide line between two points in the given colour
 	void DrawLine( Point2D start, Point2D end, Colour col );
 	// Draws a single-pixel wide circle in the given colour
 	void DrawCircle( Point2D pos, int radius, Colour col );
 	// Draws a rectangle in the given colour
 	void DrawRect( Point2D topLeft, Point2D bottomRight, Colour col, bool fill = false );
-	// Draws a line between two points using a sprite
-	// > Note that colouring affects subsequent DrawSprite calls using the same sprite!!
+	// Draws a line between two points using a sprite tinted with the given colour
 	void DrawSpriteLine( Point2D startPos, Point2D endPos, const char* penSprite, Colour c = cWhite );
-	// Draws a circle using a sprite
-	// > Note that colouring affects subsequent DrawSprite calls using the same sprite!!
+	// Draws a circle using a sprite tinted with the given colour
 	void DrawSpriteCircle( Point2D pos, int radius, const char* penSprite, Colour c = cWhite );
 	// Draws text using a sprite-based font exported from PlayFontTool
 	void DrawFontText( const char* fontId, std::string text, Point2D pos, Align justify = LEFT );
+	// Gets the width in pixels of text drawn with DrawFontText (e.g. to size a render layer to fit it)
+	int GetFontTextWidth( const char* fontId, std::string text );
 	// Adds a sprite dynamically from memory (custom asset pipelines)
 
 	// Resets the timing bar data and sets the current timing bar segment to a specific colour
@@ -1709,15 +2737,82 @@ namespace Play
 	// Performs a typical update of the object's position and animation
 	// > Cam only be called once per object per frame unless allowMultipleUpdatesPerFrame is set to true
 	void UpdateGameObject( GameObject& object, bool bWrap = false, int wrapBorderSize = 0, bool allowMultipleUpdatesPerFrame = false );
+	// > Setting obj.updateInterval to N makes UpdateGameObject only move the object every Nth frame, but N times as far
+	// > Setting obj.asleep makes UpdateGameObject leave the object where it is until it is woken (by clearing obj.asleep or the functions below)
+	// Wakes up all the sleeping GameObjects whose collision radii overlap the given circle
+	// > The type mask selects which types are included: bit n is set to include type n, or all bits for every type
+	// > Returns the number of objects woken
+	int WakeGameObjectsNear( Point2f pos, int radius, unsigned int typeMask = 0xFFFFFFFF );
+	// Wakes up sleeping GameObjects automatically when they come within the given distance of the edge of the screen (negative turns it off)
+	// > Checked once a frame, the first time a GameObject is updated
+	void SetCameraWakeDistance( float distance );
 	// Deletes the GameObject with the corresponding id
 	//> Use GameObject.GetId() to find out its unique id
 	void DestroyGameObject( int id );
 	// Deletes all GameObjects with the corresponding type
 	void DestroyGameObjectsByType( int type );
+	// Deletes all GameObjects in one go (much faster than deleting them individually)
+	void DestroyAllGameObjects();
+	// Changes the type of a GameObject (and moves it to the manager's list for its new type)
+	void SetGameObjectType( GameObject& obj, int type );
+	// Calls the function for every GameObject of the given type, passing pData through to it
+	// > Objects can safely be created, destroyed or have their type changed by the function
+	// > Objects created by the function aren't visited, and objects destroyed or changed to a different type before their turn are skipped
+	void ForEachGameObject( int type, void ( *pFunction )( GameObject& obj, void* pData ), void* pData );
+	// Calls the function (e.g. a lambda) for every GameObject of the given type
+	template< typename Function >
+	void ForEachGameObject( int type, Function function )
+	{
+		ForEachGameObject( type, []( GameObject& obj, void* pData ) { ( *static_cast<Function*>( pData ) )( obj ); }, &function );
+	}
+	// Calls the function for every GameObject of the given type, spread over all the cores, passing pData through to it
+	// > The function can change and draw the object it's given (including calling UpdateGameObject on it) but mustn't change other objects
+	// > It should create and destroy objects, change their types and play audio with the commands, which are carried out afterwards
+	// > The order of the commands and drawing is the same as if the objects were updated one at a time, however many cores there are
+	// > Drawing is on the current draw layer (see SetDrawLayer) unless the function changes it, and happens before the commands
+	void ParallelUpdateGameObjects( int type, void ( *pFunction )( GameObject& obj, GameObjectCommands& commands, void* pData ), void* pData );
+	// Calls the function (e.g. a lambda taking the object and the commands) for every GameObject of the given type, spread over all the cores
+	template< typename Function >
+	void ParallelUpdateGameObjects( int type, Function function )
+	{
+		ParallelUpdateGameObjects( type, []( GameObject& obj, GameObjectCommands& commands, void* pData ) { ( *static_cast<Function*>( pData ) )( obj, commands ); }, &function );
+	}
+	// Queues the GameObject with the corresponding id to be deleted at the end of the frame (in Play::PresentDrawingBuffer)
+	// > The object can still be used until then, so it's safe to call while other code is still working with the object
+	void DestroyGameObjectDeferred( int id );
+	// Deletes all the GameObjects queued by Play::DestroyGameObjectDeferred straight away
+	void FlushDestroyedGameObjects();
 	
 	// Checks whether the two objects are within each other's collision radii
 	bool IsColliding( GameObject& obj1, GameObject& obj2 );
+	// Checks whether any of the solid pixels of the two objects' sprites overlap, taking their rotations into account
+	// > Exact for any shape of sprite, but slower than IsColliding so it works well as a second check after IsColliding
+	// > The objects' scales are ignored
+	bool IsCollidingPixel( GameObject& obj1, GameObject& obj2 );
+	// Collects the IDs of all the GameObjects whose collision radii overlap the given circle
+	// > The type mask selects which types are included: bit n is set to include type n (e.g. 1 << TYPE_COIN), or all bits for every type
+	// > Only nearby objects are checked (several at once using CollideCircles), so this is much faster than calling IsColliding on every object
+	// > Unlike IsColliding, the positions aren't rounded to whole pixels
+	std::vector<int> QueryCircle( Point2f pos, int radius, unsigned int typeMask = 0xFFFFFFFF );
+	// Collects the IDs of every colliding pair of GameObjects where the first has typeA and the second has typeB
+	// > Each object is only checked against the objects near it, so the cost depends on how many objects are close together
+	std::vector< std::pair<int, int> > CollectCollidingPairs( int typeA, int typeB );
+	// Sets the size of the cells used to find nearby objects for QueryCircle and CollectCollidingPairs (defaults to 64 pixels)
+	// > Works best when it's a bit bigger than the typical collision radius
+	void SetCollisionGridCellSize( int cellSize );
+	// Sets whether GameObjects on the two collision layers (0-31) collide with each other in Play::UpdateCollisions
+	// > No layers collide until they are enabled here, and an object's collisionMask can also rule out layers for that object
+	void SetLayerCollision( int layerA, int layerB, bool collide );
+	// Finds every colliding pair of GameObjects on layers which collide with each other in a single pass
+	// > Call once per frame after the objects have moved, then read the results with Play::GetCollisionPairs
+	void UpdateCollisions();
+	// Gets the pairs found by the last call to Play::UpdateCollisions, sorted by idA and then idB
+	// > idA is the object on the lower layer (or the one with the lower id when both are on the same layer)
+	// > Pairs which have stopped colliding are included once with the COLLISION_EXIT state (either object may have been destroyed)
+	const std::vector<CollisionPair>& GetCollisionPairs();
 	// Checks whether any part of the object is visible within the DisplayBuffer
+	// > The visibility of every object is worked out in one go the first time it's needed each frame (or after the camera moves),
+	//   so this is usually just a lookup. Objects which have moved since then are checked again individually
 	bool IsVisible( GameObject& obj );
 	// Checks whether the object is overlapping the edge of the screen and moving outwards 
 	bool IsLeavingDisplayArea( GameObject& obj, Direction dirn = ALL );
@@ -1732,11 +2827,12 @@ namespace Play
 	// Changes the object's current spite and resets its animation frame to the start
 	void SetSprite( GameObject& obj, const char* spriteName, float animSpeed );
 	// Draws the object's sprite without rotation or transparency (fastest)
+	// > All the DrawObject functions skip objects which are definitely off the screen
 	void DrawObject( GameObject& obj );
 	// Draws the object's sprite with transparency (slower than DrawObject)
-	void DrawObjectTransparent( GameObject& obj, float opacity );
+	void DrawObjectTransparent( GameObject& obj, float opacity, Colour tint = cWhite );
 	// Draws the object's sprite with rotation and transparency (slower than DrawObject)
-	void DrawObjectRotated( GameObject& obj, float opacity = 1.0f );
+	void DrawObjectRotated( GameObject& obj, float opacity = 1.0f, Colour tint = cWhite );
 
 #endif
 
@@ -2017,6 +3113,12 @@ void PrintAllocations( const char* tagText )
 // Instruct Visual Studio to add these to the list of libraries to link
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "dwmapi.lib")
+#pragma comment(lib, "winmm.lib")
+
+// High resolution waitable timers need Windows 10 version 1803, but older SDKs don't define the flag
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 PlayWindow* PlayWindow::s_pInstance = nullptr;
 
@@ -2141,6 +3243,11 @@ int PlayWindow::HandleWindows( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPS
 	QueryPerformanceCounter( &lastDrawTime );
 	QueryPerformanceFrequency( &frequency );
 
+	// Sleep between frames on a high resolution timer if there is one, or make Sleep as accurate as it can be if not
+	m_hFrameTimer = CreateWaitableTimerExW( nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS );
+	if( !m_hFrameTimer )
+		timeBeginPeriod( 1 );
+
 	// Standard windows message loop
 	while( !quit )
 	{
@@ -2157,24 +3264,43 @@ int PlayWindow::HandleWindows( HINSTANCE hInstance, HINSTANCE hPrevInstance, LPS
 			}
 		}
 
-		do
+		if( m_bFrameUnchanged )
 		{
+			// Nothing needs drawing until something happens, so wait for input (or the idle timeout) rather than the next frame
+			MsgWaitForMultipleObjectsEx( 0, nullptr, IDLE_WAIT_MS, QS_ALLINPUT, MWMO_INPUTAVAILABLE );
 			QueryPerformanceCounter( &now );
 			elapsedTime = ( now.QuadPart - lastDrawTime.QuadPart ) * 1000.0 / frequency.QuadPart;
-
-		} while( elapsedTime < 1000.0f / FRAMES_PER_SECOND );
+			m_bFrameUnchanged = false;
+		}
+		else
+		{
+			elapsedTime = WaitForNextFrame( lastDrawTime, frequency, now );
+			RecordFrameTime( elapsedTime );
+		}
 
 		// Call the main game update function (only while we have the input focus in release mode)
 #ifndef _DEBUG
 		if( GetFocus() == m_hWindow )
 #endif
 			quit = MainGameUpdate( static_cast<float>( elapsedTime ) / 1000.0f );
+
+		LARGE_INTEGER updated;
+		QueryPerformanceCounter( &updated );
+		m_updateTime = static_cast<float>( ( updated.QuadPart - now.QuadPart ) * 1000.0 / frequency.QuadPart );
 		
 		lastDrawTime = now;
 
-		DwmFlush(); // Waits for DWM compositor to finish
+		// An unchanged frame wasn't presented, so there's nothing for the compositor to finish
+		if( !m_bPresentWaits && !m_bFrameUnchanged )
+			DwmFlush(); // Waits for DWM compositor to finish
 	}
 
+	if( m_hFrameTimer )
+		CloseHandle( m_hFrameTimer );
+	else
+		timeEndPeriod( 1 );
+	m_hFrameTimer = nullptr;
+
 	// Call the main game cleanup function
 	MainGameExit();
 
@@ -2192,6 +3318,8 @@ LRESULT CALLBACK PlayWindow::WndProc( HWND hWnd, UINT message, WPARAM wParam, LP
 			PAINTSTRUCT ps;
 			BeginPaint( hWnd, &ps );
 			EndPaint( hWnd, &ps );
+			// The window's contents come from the game's frames, so the repaint happens when the next one is presented
+			s_pInstance->m_bRepaintRequested = true;
 			break;
 
 		case WM_DESTROY:
@@ -2230,7 +3358,7 @@ LRESULT CALLBACK PlayWindow::WndProc( HWND hWnd, UINT message, WPARAM wParam, LP
 	return 0;
 }
 
-double PlayWindow::Present( void )
+double PlayWindow::Present( const PixelData& displayBuffer )
 {
 	LARGE_INTEGER frequency;
 	LARGE_INTEGER before;
@@ -2242,7 +3370,7 @@ double PlayWindow::Present( void )
 	BITMAPINFOHEADER bitmap_info_header
 	{
 			sizeof( BITMAPINFOHEADER ),								// size of its own data,
-			m_pPlayBuffer->width, m_pPlayBuffer->height,		// width and height
+			displayBuffer.width, displayBuffer.height,		// width and height
 			1, 32, BI_RGB,				// planes must always be set to 1 (docs), 32-bit pixel data, uncompressed 
 			0, 0, 0, 0, 0				// rest can be set to 0 as this is uncompressed and has no palette
 	};
@@ -2253,7 +3381,7 @@ double PlayWindow::Present( void )
 
 	// Copy the display buffer to the window: GDI only implements up scaling using simple pixel duplication, but that's what we want
 	// Note that GDI+ DrawImage would do the same thing, but it's much slower! 
-	StretchDIBits( hDC, 0, 0, m_pPlayBuffer->width * m_scale, m_pPlayBuffer->height * m_scale, 0, m_pPlayBuffer->height + 1, m_pPlayBuffer->width, -m_pPlayBuffer->height, m_pPlayBuffer->pPixels, &bitmap_info, DIB_RGB_COLORS, SRCCOPY ); // We flip h because Bitmaps store pixel data upside down.
+	StretchDIBits( hDC, 0, 0, displayBuffer.width * m_scale, displayBuffer.height * m_scale, 0, displayBuffer.height + 1, displayBuffer.width, -displayBuffer.height, displayBuffer.pPixels, &bitmap_info, DIB_RGB_COLORS, SRCCOPY ); // We flip h because Bitmaps store pixel data upside down.
 	
 	ReleaseDC( m_hWindow, hDC );
 
@@ -2261,9 +3389,87 @@ double PlayWindow::Present( void )
 
 	double elapsedTime = ( after.QuadPart - before.QuadPart ) * 1000.0 / frequency.QuadPart;
 
+	if( m_bPresentWaits )
+		DwmFlush();
+
 	return elapsedTime;
 }
 
+//********************************************************************************************************************************
+// Frame pacing functions
+//********************************************************************************************************************************
+
+void PlayWindow::SetTargetFrameRate( int framesPerSecond )
+{
+	PLAY_ASSERT_MSG( framesPerSecond >= 0, "The target frame rate can't be negative!" );
+	m_targetFrameRate = framesPerSecond;
+	m_frameTimeCount = 0;
+}
+
+double PlayWindow::WaitForNextFrame( LARGE_INTEGER lastDrawTime, LARGE_INTEGER frequency, LARGE_INTEGER& now )
+{
+	double targetTime = m_targetFrameRate > 0 ? 1000.0 / m_targetFrameRate : 0.0;
+	double spinTime = m_hFrameTimer ? PACING_SPIN_HIGH_RESOLUTION : PACING_SPIN_SLEEP;
+
+	for( ;; )
+	{
+		QueryPerformanceCounter( &now );
+		double elapsedTime = ( now.QuadPart - lastDrawTime.QuadPart ) * 1000.0 / frequency.QuadPart;
+		double remainingTime = targetTime - elapsedTime;
+
+		if( remainingTime <= 0.0 )
+			return elapsedTime;
+
+		if( remainingTime > spinTime )
+		{
+			double sleepTime = remainingTime - spinTime;
+			if( m_hFrameTimer )
+			{
+				// Negative due times are relative, in 100 nanosecond units
+				LARGE_INTEGER dueTime;
+				dueTime.QuadPart = -static_cast<LONGLONG>( sleepTime * 10000.0 );
+				SetWaitableTimer( m_hFrameTimer, &dueTime, 0, nullptr, nullptr, FALSE );
+				WaitForSingleObject( m_hFrameTimer, INFINITE );
+			}
+			else
+			{
+				Sleep( static_cast<DWORD>( sleepTime ) );
+			}
+		}
+		else
+		{
+			YieldProcessor();
+		}
+	}
+}
+
+void PlayWindow::RecordFrameTime( double frameTime )
+{
+	m_vFrameTimes[m_frameTimeCount % PACING_HISTORY] = frameTime;
+	m_frameTimeCount++;
+	m_frameTime = static_cast<float>( frameTime );
+
+	int count = std::min( m_frameTimeCount, PACING_HISTORY );
+	double total = 0.0;
+	for( int f = 0; f < count; f++ )
+		total += m_vFrameTimes[f];
+	double average = total / count;
+
+	// Uncapped frames are never late, so they're measured against the average instead
+	double dueTime = m_targetFrameRate > 0 ? 1000.0 / m_targetFrameRate : average;
+	double variance = 0.0;
+	double worstError = 0.0;
+	for( int f = 0; f < count; f++ )
+	{
+		variance += ( m_vFrameTimes[f] - average ) * ( m_vFrameTimes[f] - average );
+		worstError = std::max( worstError, std::abs( m_vFrameTimes[f] - dueTime ) );
+	}
+
+	m_frameTimeAverage = static_cast<float>( average );
+	m_frameTimeJitter = static_cast<float>( sqrt( variance / count ) );
+	m_frameTimeWorstError = static_cast<float>( worstError );
+}
+
 //********************************************************************************************************************************
 // Loading functions
 //********************************************************************************************************************************
@@ -2395,6 +3601,9 @@ void TracePrintf( const char* file, int line, const char* fmt, ... )
 // Platform:	Independent
 //********************************************************************************************************************************
 
+thread_local std::vector< PlayBlitter::DrawCommand >* PlayBlitter::s_pThreadDrawList = nullptr;
+thread_local uint32_t PlayBlitter::s_threadDrawKey = 0;
+thread_local int PlayBlitter::s_threadDrawLayer = 0;
 
 PlayBlitter::PlayBlitter( PixelData* pRenderTarget )
 {
@@ -2404,6 +3613,17 @@ PlayBlitter::PlayBlitter( PixelData* pRenderTarget )
 
 void PlayBlitter::DrawPixel( int posX, int posY, Pixel srcPix ) const
 {
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::DRAW_PIXEL;
+		command.x = posX;
+		command.y = posY;
+		command.pix = srcPix;
+		Record( command );
+		return;
+	}
+
 	if( srcPix.a == 0x00 || posX < 0 || posX >= m_pRenderTarget->width || posY < 0 || posY >= m_pRenderTarget->height )
 		return;
 
@@ -2432,6 +3652,19 @@ void PlayBlitter::DrawPixel( int posX, int posY, Pixel srcPix ) const
 
 void PlayBlitter::DrawLine( int startX, int startY, int endX, int endY, Pixel pix ) const
 {
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::DRAW_LINE;
+		command.x = startX;
+		command.y = startY;
+		command.width = endX;
+		command.height = endY;
+		command.pix = pix;
+		Record( command );
+		return;
+	}
+
 	//Implementation of Bresenham's Line Drawing Algorithm
 	int dx = abs( endX - startX );
 	int sx = 1;
@@ -2476,10 +3709,27 @@ void PlayBlitter::DrawLine( int startX, int startY, int endX, int endY, Pixel pi
 //				blitX, blitY = the position you want to draw the sprite within the buffer
 //				blitWidth, blitHeight = the width and height of the animation frame
 //				alphaMultiply = additional transparancy applied to the whole sprite
+//				tint = colour multiplied with the pre-multiplied source pixels as they are drawn
 // Notes:		Alpha multiply approach is ~50% slower
 //********************************************************************************************************************************
-void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int blitX, int blitY, int blitWidth, int blitHeight, float alphaMultiply ) const
-{
+void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int blitX, int blitY, int blitWidth, int blitHeight, float alphaMultiply, Pixel tint ) const
+{
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::BLIT_PIXELS;
+		command.source = srcPixelData;
+		command.offset = srcOffset;
+		command.x = blitX;
+		command.y = blitY;
+		command.width = blitWidth;
+		command.height = blitHeight;
+		command.alpha = alphaMultiply;
+		command.pix = tint;
+		Record( command );
+		return;
+	}
+
 	PLAY_ASSERT_MSG( m_pRenderTarget, "Render target not set for PlayBlitter" );
 
 	// Nothing within the display buffer to draw
@@ -2517,6 +3767,10 @@ void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int
 	//How many pixels per row in sprite.
 	int endRow = blitWidth - xClipEnd - xClipStart;
 
+	// Only tint the source when the colour isn't white
+	bool bTint = ( tint.bits & 0x00FFFFFF ) != 0x00FFFFFF;
+	__m128i tintMul = TintMultiplier( tint );
+
 	if( alphaMultiply < 1.0f )
 	{
 		// *******************************************************************************************************************************************************
@@ -2537,6 +3791,8 @@ void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int
 				// If this isn't a fully transparent pixel 
 				if( src < 0xFF000000 )
 				{
+					if( bTint ) src = TintPixel( src, tintMul );
+
 					int srcAlpha = static_cast<int>( ( 0xFF - ( src >> 24 ) ) * alphaMultiply );
 					int constAlpha = static_cast<int>( 255 * alphaMultiply );
 
@@ -2598,6 +3854,8 @@ void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int
 				// If this isn't a fully transparent pixel 
 				if( src < 0xFF000000 )
 				{
+					if( bTint ) src = TintPixel( src, tintMul );
+
 					// This performes the dest*(1-srcAlpha) calculation for all channels in parallel with minor accuracy loss in dest colour.
 					// It does this by shifting all the destination channels down by 4 bits in order to "make room" for the later multiplication.
 					// After shifting down, it masks out the bits which have shifted into the adjacent channel data.
@@ -2638,10 +3896,27 @@ void PlayBlitter::BlitPixels( const PixelData& srcPixelData, int srcOffset, int
 //				srcDrawWidth, srcDrawHeight = the width and height of the source image frame
 //				srcOrigin = the centre of rotation for the source image
 //				alphaMultiply = additional transparancy applied to the whole sprite
-// Notes:		Much slower than BlitPixels, alphaMultiply is a negligable overhead compared to the rotation
+//				tint = colour multiplied with the pre-multiplied source pixels as they are drawn
+// Notes:		Much slower than BlitPixels, alphaMultiply and tint are a negligable overhead compared to the rotation
 //********************************************************************************************************************************
-void PlayBlitter::TransformPixels( const PixelData& srcPixelData, int srcFrameOffset, int srcDrawWidth, int srcDrawHeight, const Point2f& srcOrigin, const Matrix2D& transform, float alphaMultiply ) const
-{ 
+void PlayBlitter::TransformPixels( const PixelData& srcPixelData, int srcFrameOffset, int srcDrawWidth, int srcDrawHeight, const Point2f& srcOrigin, const Matrix2D& transform, float alphaMultiply, Pixel tint ) const
+{
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::TRANSFORM_PIXELS;
+		command.source = srcPixelData;
+		command.offset = srcFrameOffset;
+		command.width = srcDrawWidth;
+		command.height = srcDrawHeight;
+		command.origin = srcOrigin;
+		command.transform = transform;
+		command.alpha = alphaMultiply;
+		command.pix = tint;
+		Record( command );
+		return;
+	}
+
 	static float inf = std::numeric_limits<float>::infinity();
 	float tgt_minx{ inf }, tgt_miny{ inf }, tgt_maxx{ -inf }, tgt_maxy{ -inf };
 
@@ -2693,6 +3968,10 @@ void PlayBlitter::TransformPixels( const PixelData& srcPixelData, int srcFrameOf
 	uint32_t* tgt_pixel = (uint32_t*)m_pRenderTarget->pPixels + tgt_start_pixel_index;
 	uint32_t* tgt_column_end = tgt_pixel + (tgt_draw_height * tgt_buffer_width );
 
+	// Only tint the source when the colour isn't white
+	bool bTint = ( tint.bits & 0x00FFFFFF ) != 0x00FFFFFF;
+	__m128i tintMul = TintMultiplier( tint );
+
 	// Iterate through each pixel on the screen in turn
 	while( tgt_pixel < tgt_column_end )
 	{
@@ -2711,6 +3990,8 @@ void PlayBlitter::TransformPixels( const PixelData& srcPixelData, int srcFrameOf
 				// If this isn't a fully transparent pixel 
 				if( src < 0xFF000000 )
 				{
+					if( bTint ) src = TintPixel( src, tintMul );
+
 					int srcAlpha = static_cast<int>( ( 0xFF - ( src >> 24 ) ) * alphaMultiply );
 					int constAlpha = static_cast<int>( 255 * alphaMultiply );
 
@@ -2753,8 +4034,32 @@ void PlayBlitter::TransformPixels( const PixelData& srcPixelData, int srcFrameOf
 }
 
 
+__m128i PlayBlitter::TintMultiplier( Pixel tint )
+{
+	// One 16-bit multiplier per channel in memory order (b,g,r,a). Adding one means white (0xFF) leaves the channel unchanged
+	// after the >>8 and the multiplier of 256 for the (inverted) alpha channel leaves it untouched.
+	return _mm_setr_epi16( tint.b + 1, tint.g + 1, tint.r + 1, 256, 0, 0, 0, 0 );
+}
+
+uint32_t PlayBlitter::TintPixel( uint32_t src, __m128i tintMul )
+{
+	// Unpack the four channels into 16-bit lanes, multiply them all at once and pack them back down again
+	__m128i channels = _mm_unpacklo_epi8( _mm_cvtsi32_si128( static_cast<int>( src ) ), _mm_setzero_si128() );
+	channels = _mm_srli_epi16( _mm_mullo_epi16( channels, tintMul ), 8 );
+	return static_cast<uint32_t>( _mm_cvtsi128_si32( _mm_packus_epi16( channels, channels ) ) );
+}
+
 void PlayBlitter::ClearRenderTarget( Pixel colour ) const
 {
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::CLEAR;
+		command.pix = colour;
+		Record( command );
+		return;
+	}
+
 	Pixel* pBuffEnd = m_pRenderTarget->pPixels + ( m_pRenderTarget->width * m_pRenderTarget->height );
 	for( Pixel* pBuff = m_pRenderTarget->pPixels; pBuff < pBuffEnd; *pBuff++ = colour.bits );
 	m_pRenderTarget->preMultiplied = false;
@@ -2762,11 +4067,319 @@ void PlayBlitter::ClearRenderTarget( Pixel colour ) const
 
 void PlayBlitter::BlitBackground( PixelData& backgroundImage ) const
 {
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::BLIT_BACKGROUND;
+		command.source = backgroundImage;
+		Record( command );
+		return;
+	}
+
 	PLAY_ASSERT_MSG( backgroundImage.height == m_pRenderTarget->height && backgroundImage.width == m_pRenderTarget->width, "Background size doesn't match render target!" );
 	// Takes about 1ms for 720p screen on i7-8550U
 	memcpy( m_pRenderTarget->pPixels, backgroundImage.pPixels, sizeof( Pixel ) * m_pRenderTarget->width * m_pRenderTarget->height );
 }
 
+//********************************************************************************************************************************
+// Function:	BlitBackground - copies or blends a background image of any size to the render target
+// Parameters:	backgroundImage = the image to draw (opaque, or pre-multiplied if it contains transparency)
+//				scrollX, scrollY = the position in the background image which appears at the top left of the render target
+//				tile = whether the image wraps around to fill the whole render target
+// Notes:		Each row is split into spans which end at the edge of the image, so opaque images are just a few memcpys per row
+//********************************************************************************************************************************
+void PlayBlitter::BlitBackground( const PixelData& backgroundImage, int scrollX, int scrollY, bool tile ) const
+{
+	if( IsRecording() )
+	{
+		DrawCommand command;
+		command.operation = DrawCommand::BLIT_BACKGROUND_SCROLLED;
+		command.source = backgroundImage;
+		command.x = scrollX;
+		command.y = scrollY;
+		command.tile = tile;
+		Record( command );
+		return;
+	}
+
+	PLAY_ASSERT_MSG( m_pRenderTarget, "Render target not set for PlayBlitter" );
+	PLAY_ASSERT_MSG( backgroundImage.width > 0 && backgroundImage.height > 0, "Invalid background image!" );
+
+	int bgWidth = backgroundImage.width;
+	int bgHeight = backgroundImage.height;
+	int targetWidth = m_pRenderTarget->width;
+
+	// An image which isn't tiled only covers part of each row of the render target
+	int destStartX = 0;
+	int destEndX = targetWidth;
+
+	if( !tile )
+	{
+		destStartX = std::max( -scrollX, 0 );
+		destEndX = std::min( bgWidth - scrollX, targetWidth );
+		if( destStartX >= destEndX )
+			return;
+	}
+
+	for( int y = 0; y < m_pRenderTarget->height; y++ )
+	{
+		int srcY = y + scrollY;
+
+		if( tile )
+			srcY = ( ( srcY % bgHeight ) + bgHeight ) % bgHeight;
+		else if( srcY < 0 || srcY >= bgHeight )
+			continue;
+
+		const Pixel* pSrcRow = backgroundImage.pPixels + ( srcY * bgWidth );
+		Pixel* pDest = m_pRenderTarget->pPixels + ( y * targetWidth ) + destStartX;
+
+		for( int destX = destStartX; destX < destEndX; )
+		{
+			int srcX = destX + scrollX;
+			if( tile )
+				srcX = ( ( srcX % bgWidth ) + bgWidth ) % bgWidth;
+
+			// Each span runs to the end of the image row or the end of the render target row, whichever comes first
+			int span = std::min( bgWidth - srcX, destEndX - destX );
+
+			if( backgroundImage.preMultiplied )
+				BlendBackgroundSpan( pSrcRow + srcX, pDest, span );
+			else
+				memcpy( pDest, pSrcRow + srcX, sizeof( Pixel ) * span );
+
+			pDest += span;
+			destX += span;
+		}
+	}
+}
+
+void PlayBlitter::ExecuteDrawList( const std::vector< DrawCommand >& vDrawList ) const
+{
+	if( IsRecording() )
+	{
+		PLAY_ASSERT_MSG( &vDrawList != m_pDrawList && &vDrawList != s_pThreadDrawList, "Trying to execute a draw list into itself!" );
+
+		for( DrawCommand command : vDrawList )
+			Record( command );
+		return;
+	}
+
+	for( const DrawCommand& c : vDrawList )
+	{
+		switch( c.operation )
+		{
+			case DrawCommand::DRAW_PIXEL:
+				DrawPixel( c.x, c.y, c.pix );
+				break;
+			case DrawCommand::DRAW_LINE:
+				DrawLine( c.x, c.y, c.width, c.height, c.pix );
+				break;
+			case DrawCommand::BLIT_PIXELS:
+				BlitPixels( c.source, c.offset, c.x, c.y, c.width, c.height, c.alpha, c.pix );
+				break;
+			case DrawCommand::TRANSFORM_PIXELS:
+				TransformPixels( c.source, c.offset, c.width, c.height, c.origin, c.transform, c.alpha, c.pix );
+				break;
+			case DrawCommand::CLEAR:
+				ClearRenderTarget( c.pix );
+				break;
+			case DrawCommand::BLIT_BACKGROUND:
+			{
+				PixelData background = c.source;
+				BlitBackground( background );
+				break;
+			}
+			case DrawCommand::BLIT_BACKGROUND_SCROLLED:
+				BlitBackground( c.source, c.x, c.y, c.tile );
+				break;
+		}
+	}
+}
+
+void PlayBlitter::Record( DrawCommand& command ) const
+{
+	if( s_pThreadDrawList )
+	{
+		command.layer = s_threadDrawLayer;
+		command.key = s_threadDrawKey;
+		s_pThreadDrawList->push_back( command );
+	}
+	else
+	{
+		m_pDrawList->push_back( command );
+	}
+}
+
+void PlayBlitter::BlendBackgroundSpan( const Pixel* pSrc, Pixel* pDest, int count )
+{
+	const Pixel* pSrcEnd = pSrc + count;
+
+	while( pSrc < pSrcEnd )
+	{
+		uint32_t src = pSrc->bits;
+		uint32_t invAlpha = src >> 24;
+
+		if( invAlpha == 0xFF )
+		{
+			// Fully transparent pixels store the number of transparent pixels which follow them on the same row
+			int skip = std::min( 1 + static_cast<int>( src & 0x00FFFFFF ), static_cast<int>( pSrcEnd - pSrc ) );
+			pSrc += skip;
+			pDest += skip;
+			continue;
+		}
+
+		if( invAlpha == 0x00 )
+		{
+			*pDest = src | 0xFF000000;
+		}
+		else
+		{
+			// Red and blue are multiplied together as they have a spare byte between them
+			uint32_t dest = pDest->bits;
+			uint32_t destRedBlue = ( ( ( dest & 0x00FF00FF ) * invAlpha ) >> 8 ) & 0x00FF00FF;
+			uint32_t destGreen = ( ( ( dest & 0x0000FF00 ) * invAlpha ) >> 8 ) & 0x0000FF00;
+			*pDest = ( ( src & 0x00FFFFFF ) + destRedBlue + destGreen ) | 0xFF000000;
+		}
+
+		pSrc++;
+		pDest++;
+	}
+}
+
+//********************************************************************************************************************************
+// Function:	UpscalePixels - stretches an opaque image to fill a larger one
+// Parameters:	source = the image to stretch (e.g. a frame drawn at a lower resolution)
+//				dest = the image to fill, which must be at least as big as the source
+//				smooth = whether to blend the four nearest source pixels (bilinear) rather than repeat the nearest one
+// Notes:		Exactly double the size is a fast path which writes each source pixel twice with SSE and copies each row twice.
+//				Otherwise positions step through the source in 16.16 fixed point, from the centre of each destination pixel
+//********************************************************************************************************************************
+void PlayBlitter::UpscalePixels( const PixelData& source, PixelData& dest, bool smooth )
+{
+	PLAY_ASSERT_MSG( source.width > 0 && source.height > 0 && source.width <= dest.width && source.height <= dest.height, "Upscaling must make the image larger!" );
+
+	int srcWidth = source.width;
+	int srcHeight = source.height;
+	int destWidth = dest.width;
+	int destHeight = dest.height;
+
+	if( !smooth && destWidth == srcWidth * 2 && destHeight == srcHeight * 2 )
+	{
+		for( int y = 0; y < srcHeight; y++ )
+		{
+			const Pixel* pSrcRow = source.pPixels + ( y * srcWidth );
+			Pixel* pDestRow = dest.pPixels + ( y * 2 * destWidth );
+			int x = 0;
+
+			for( ; x + 4 <= srcWidth; x += 4 )
+			{
+				__m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSrcRow + x ) );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDestRow + ( x * 2 ) ), _mm_unpacklo_epi32( pixels, pixels ) );
+				_mm_storeu_si128( reinterpret_cast<__m128i*>( pDestRow + ( x * 2 ) + 4 ), _mm_unpackhi_epi32( pixels, pixels ) );
+			}
+
+			for( ; x < srcWidth; x++ )
+				pDestRow[x * 2] = pDestRow[( x * 2 ) + 1] = pSrcRow[x];
+
+			memcpy( pDestRow + destWidth, pDestRow, sizeof( Pixel ) * destWidth );
+		}
+		return;
+	}
+
+	uint32_t stepX = ( static_cast<uint32_t>( srcWidth ) << 16 ) / destWidth;
+	uint32_t stepY = ( static_cast<uint32_t>( srcHeight ) << 16 ) / destHeight;
+
+	if( !smooth )
+	{
+		int lastSrcY = -1;
+
+		for( int y = 0; y < destHeight; y++ )
+		{
+			Pixel* pDestRow = dest.pPixels + ( y * destWidth );
+			int srcY = static_cast<int>( ( ( y * stepY ) + ( stepY / 2 ) ) >> 16 );
+
+			// Rows which repeat the same source row are just copied
+			if( srcY == lastSrcY )
+			{
+				memcpy( pDestRow, pDestRow - destWidth, sizeof( Pixel ) * destWidth );
+				continue;
+			}
+
+			const Pixel* pSrcRow = source.pPixels + ( srcY * srcWidth );
+			uint32_t srcX = stepX / 2;
+
+			for( int x = 0; x < destWidth; x++, srcX += stepX )
+				pDestRow[x] = pSrcRow[srcX >> 16];
+
+			lastSrcY = srcY;
+		}
+		return;
+	}
+
+	// The source position of each column and the weights of its two pixels (one per channel) are the same for every row
+	std::vector< int > vColumns( destWidth );
+	std::vector< int16_t > vColumnWeights( static_cast<size_t>( destWidth ) * 8 );
+
+	for( int x = 0; x < destWidth; x++ )
+	{
+		int posX = std::max( static_cast<int>( ( x * stepX ) + ( stepX / 2 ) ) - 0x8000, 0 );
+		int16_t weight = static_cast<int16_t>( ( posX >> 8 ) & 0xFF );
+		vColumns[x] = posX >> 16;
+
+		for( int c = 0; c < 4; c++ )
+		{
+			vColumnWeights[( x * 8 ) + c] = 256 - weight;
+			vColumnWeights[( x * 8 ) + 4 + c] = weight;
+		}
+	}
+
+	// Each row is blended from two source rows into a temporary row first, with an extra copy of the last pixel for the right hand edge
+	std::vector< Pixel > vRow( srcWidth + 1 );
+	__m128i zero = _mm_setzero_si128();
+
+	for( int y = 0; y < destHeight; y++ )
+	{
+		int posY = std::max( static_cast<int>( ( y * stepY ) + ( stepY / 2 ) ) - 0x8000, 0 );
+		int srcY = posY >> 16;
+		int weight = ( posY >> 8 ) & 0xFF;
+		const Pixel* pTop = source.pPixels + ( srcY * srcWidth );
+		const Pixel* pBottom = source.pPixels + ( std::min( srcY + 1, srcHeight - 1 ) * srcWidth );
+
+		// The weights add up to 256, so the blended channels (at most 255 * 256) still fit in 16 bits
+		__m128i topWeight = _mm_set1_epi16( static_cast<short>( 256 - weight ) );
+		__m128i bottomWeight = _mm_set1_epi16( static_cast<short>( weight ) );
+		int x = 0;
+
+		for( ; x + 4 <= srcWidth; x += 4 )
+		{
+			__m128i top = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pTop + x ) );
+			__m128i bottom = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pBottom + x ) );
+			__m128i low = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( top, zero ), topWeight ), _mm_mullo_epi16( _mm_unpacklo_epi8( bottom, zero ), bottomWeight ) );
+			__m128i high = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( top, zero ), topWeight ), _mm_mullo_epi16( _mm_unpackhi_epi8( bottom, zero ), bottomWeight ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( &vRow[x] ), _mm_packus_epi16( _mm_srli_epi16( low, 8 ), _mm_srli_epi16( high, 8 ) ) );
+		}
+
+		for( ; x < srcWidth; x++ )
+		{
+			__m128i low = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( pTop[x].bits ), zero ), topWeight ), _mm_mullo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( pBottom[x].bits ), zero ), bottomWeight ) );
+			vRow[x].bits = _mm_cvtsi128_si32( _mm_packus_epi16( _mm_srli_epi16( low, 8 ), zero ) );
+		}
+
+		vRow[srcWidth] = vRow[srcWidth - 1];
+
+		// Then each pixel blends the two neighbouring pixels of the temporary row, which are loaded together
+		Pixel* pDestRow = dest.pPixels + ( y * destWidth );
+
+		for( x = 0; x < destWidth; x++ )
+		{
+			__m128i pair = _mm_unpacklo_epi8( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( &vRow[vColumns[x]] ) ), zero );
+			__m128i blend = _mm_mullo_epi16( pair, _mm_loadu_si128( reinterpret_cast<const __m128i*>( &vColumnWeights[x * 8] ) ) );
+			blend = _mm_srli_epi16( _mm_add_epi16( blend, _mm_srli_si128( blend, 8 ) ), 8 );
+			pDestRow[x].bits = _mm_cvtsi128_si32( _mm_packus_epi16( blend, blend ) );
+		}
+	}
+}
+
 
 //********************************************************************************************************************************
 // File:		PlayGraphics.cpp
@@ -2777,6 +4390,7 @@ void PlayBlitter::BlitBackground( PixelData& backgroundImage ) const
 
 
 PlayGraphics* PlayGraphics::s_pInstance = nullptr;
+int PlayGraphics::s_instanceCount = 0;
 
 //********************************************************************************************************************************
 // Constructor / Destructor (Private)
@@ -2784,6 +4398,8 @@ PlayGraphics* PlayGraphics::s_pInstance = nullptr;
 
 PlayGraphics::PlayGraphics( int bufferWidth, int bufferHeight, const char* path )
 {
+	m_instanceNumber = ++s_instanceCount;
+
 	// A working buffer for our display. Each pixel is stored as an unsigned 32-bit integer: alpha<<24 | red<<16 | green<<8 | blue
 	m_playBuffer.width = bufferWidth;
 	m_playBuffer.height = bufferHeight;
@@ -2848,6 +4464,9 @@ PlayGraphics::PlayGraphics( int bufferWidth, int bufferHeight, const char* path
 
 PlayGraphics::~PlayGraphics()
 {
+	SetPipelinedRendering( false );
+	SetThreadedPresent( false );
+
 	for( Sprite& s : vSpriteData )
 	{
 		if( s.canvasBuffer.pPixels )
@@ -2860,6 +4479,29 @@ PlayGraphics::~PlayGraphics()
 	for( PixelData& pBgBuffer : vBackgroundData )
 		delete[] pBgBuffer.pPixels;
 
+	for( Tilemap& map : m_vTilemaps )
+		FreeTilemapChunks( map );
+
+	for( RenderLayer& layer : m_vRenderLayers )
+	{
+		delete[] layer.canvas.pPixels;
+		delete[] layer.scaled.pPixels;
+	}
+
+	for( std::vector< PixelData >& vScaled : m_vScaledSprites )
+	{
+		for( PixelData& scaled : vScaled )
+			delete[] scaled.pPixels;
+	}
+
+	for( std::vector< PixelData >& vScaled : m_vScaledBackgrounds )
+	{
+		for( PixelData& scaled : vScaled )
+			delete[] scaled.pPixels;
+	}
+
+	delete[] m_scaledBuffer.pPixels;
+
 	if( m_pDebugFontBuffer )
 		delete[] m_pDebugFontBuffer;
 
@@ -2982,15 +4624,22 @@ int PlayGraphics::AddSprite( const std::string& name, PixelData& pixelData, int
 	memset( s.preMultAlpha.pPixels, 0, sizeof( uint32_t ) * s.canvasBuffer.width * s.canvasBuffer.height );
 	PreMultiplyAlpha( s.canvasBuffer.pPixels, s.preMultAlpha.pPixels, s.canvasBuffer.width, s.canvasBuffer.height, s.width, 1.0f, 0x00FFFFFF );
 	s.canvasBuffer.preMultiplied = true;
+	BuildCollisionMask( s );
 
 	// Add the sprite to our vector
 	vSpriteData.push_back( s );
 
+	if( m_renderScaleIndex )
+		ScaleSprite( s.id, m_renderScaleIndex );
+
 	return s.id;
 }
 
 int PlayGraphics::UpdateSprite( const std::string& name, PixelData& pixelData, int hCount, int vCount )
 {
+	// The render thread may still be drawing with the old pixels
+	WaitForRender();
+
 	// Switch everything to uppercase to avoid need to check case each time
 	std::string spriteName = name;
 	for( char& c : spriteName ) c = static_cast<char>( toupper( c ) );
@@ -3017,6 +4666,15 @@ int PlayGraphics::UpdateSprite( const std::string& name, PixelData& pixelData, i
 			memset( s.preMultAlpha.pPixels, 0, sizeof( uint32_t ) * s.canvasBuffer.width * s.canvasBuffer.height );
 			PreMultiplyAlpha( s.canvasBuffer.pPixels, s.preMultAlpha.pPixels, s.canvasBuffer.width, s.canvasBuffer.height, s.width, 1.0f, 0x00FFFFFF );
 			s.canvasBuffer.preMultiplied = true;
+			BuildCollisionMask( s );
+			RescaleSprite( s.id );
+
+			// Any tilemaps using this sprite need to be rebuilt (and the tiles may have changed size)
+			for( Tilemap& map : m_vTilemaps )
+			{
+				if( map.spriteId == s.id )
+					FreeTilemapChunks( map );
+			}
 
 			return s.id;
 		}
@@ -3028,38 +4686,88 @@ int PlayGraphics::UpdateSprite( const std::string& name, PixelData& pixelData, i
 
 int PlayGraphics::LoadBackground( const char* fileAndPath )
 {
-	// The background image may not be the right size for the background so we make sure the buffer is 
-	PixelData backgroundImage;
-	Pixel* pSrc, * pDest;
+	// Different spellings of the same path should still find the same background
+	std::string pathKey = std::filesystem::path( fileAndPath ).lexically_normal().string();
+	for( char& c : pathKey ) c = static_cast<char>( toupper( c ) );
 
-	Pixel* correctSizeBuffer = new Pixel[static_cast<size_t>( m_playBuffer.width ) * m_playBuffer.height];
-	PLAY_ASSERT( correctSizeBuffer );
+	std::map< std::string, int >::iterator it = m_backgroundPathMap.find( pathKey );
+	if( it != m_backgroundPathMap.end() )
+	{
+		m_vBackgroundRefCounts[it->second]++;
+		return it->second;
+	}
+
+	// The background image is kept at its original size so it can be scrolled and tiled when it is drawn
+	PixelData backgroundImage;
 
 	std::string pngFile( fileAndPath );
 	PLAY_ASSERT_MSG( std::filesystem::exists( fileAndPath ), "The background png does not exist at the given location." );
 	PlayWindow::LoadPNGImage( pngFile, backgroundImage ); // Allocates memory in function as we don't know the size
+	PLAY_ASSERT( backgroundImage.pPixels );
 
-	pSrc = backgroundImage.pPixels;
-	pDest = correctSizeBuffer;
+	Pixel* pEnd = backgroundImage.pPixels + ( backgroundImage.width * backgroundImage.height );
+	bool bTransparent = std::any_of( backgroundImage.pPixels, pEnd, []( const Pixel& p ) { return p.a != 0xFF; } );
 
-	//Copy the image to our background buffer clipping where necessary
-	for( int h = 0; h < std::min( backgroundImage.height, m_playBuffer.height ); h++ )
+	// Only images with transparency need blending, so everything else stays in a format which can just be copied
+	if( bTransparent )
 	{
-		for( int w = 0; w < std::min( backgroundImage.width, m_playBuffer.width ); w++ )
-			*pDest++ = *pSrc++;
+		PreMultiplyAlpha( backgroundImage.pPixels, backgroundImage.pPixels, backgroundImage.width, backgroundImage.height, backgroundImage.width, 1.0f, 0x00FFFFFF );
+		backgroundImage.preMultiplied = true;
+	}
+
+	// Reuse the slot of a background which has been unloaded so the vector doesn't keep growing
+	int backgroundId = static_cast<int>( std::find( m_vBackgroundRefCounts.begin(), m_vBackgroundRefCounts.end(), 0 ) - m_vBackgroundRefCounts.begin() );
 
-		// Skip pixels if we're clipping
-		pDest += std::max( m_playBuffer.width - backgroundImage.width, 0 );
-		pSrc += std::max( backgroundImage.width - m_playBuffer.width, 0 );
+	if( backgroundId == static_cast<int>( vBackgroundData.size() ) )
+	{
+		vBackgroundData.push_back( backgroundImage );
+		m_vBackgroundRefCounts.push_back( 1 );
+	}
+	else
+	{
+		vBackgroundData[backgroundId] = backgroundImage;
+		m_vBackgroundRefCounts[backgroundId] = 1;
 	}
 
-	// Free up the loading buffer
-	delete backgroundImage.pPixels;
-	backgroundImage.pPixels = correctSizeBuffer;
+	m_backgroundPathMap[pathKey] = backgroundId;
+
+	if( m_renderScaleIndex )
+		ScaleBackground( backgroundId );
+
+	return backgroundId;
+}
+
+void PlayGraphics::UnloadBackground( int backgroundId )
+{
+	PLAY_ASSERT_MSG( backgroundId >= 0 && vBackgroundData.size() > static_cast<size_t>( backgroundId ) && m_vBackgroundRefCounts[backgroundId] > 0, "Trying to unload a background which isn't loaded!" );
+
+	if( --m_vBackgroundRefCounts[backgroundId] > 0 )
+		return;
+
+	WaitForRender();
+
+	PLAY_ASSERT_MSG( std::none_of( m_vBackgroundLayers.begin(), m_vBackgroundLayers.end(), [backgroundId]( const BackgroundLayer& l ) { return l.backgroundId == backgroundId; } ), "Trying to unload a background which is still used by a background layer!" );
+
+	delete[] vBackgroundData[backgroundId].pPixels;
+	vBackgroundData[backgroundId] = PixelData();
 
-	vBackgroundData.push_back( backgroundImage );
+	for( std::vector< PixelData >& vScaled : m_vScaledBackgrounds )
+	{
+		if( backgroundId < static_cast<int>( vScaled.size() ) )
+		{
+			delete[] vScaled[backgroundId].pPixels;
+			vScaled[backgroundId] = PixelData();
+		}
+	}
 
-	return static_cast<int>( vBackgroundData.size() ) - 1;
+	for( std::map< std::string, int >::iterator it = m_backgroundPathMap.begin(); it != m_backgroundPathMap.end(); ++it )
+	{
+		if( it->second == backgroundId )
+		{
+			m_backgroundPathMap.erase( it );
+			break;
+		}
+	}
 }
 
 
@@ -3157,29 +4865,44 @@ void PlayGraphics::SetSpriteOrigins( const char* rootName, Vector2f newOrigin, b
 // Drawing functions
 //********************************************************************************************************************************
 
-void PlayGraphics::DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply ) const
+void PlayGraphics::DrawTransparent( int spriteId, Point2f pos, int frameIndex, float alphaMultiply, Pixel tint ) const
 {
 	const Sprite& spr = vSpriteData[spriteId];
-	int destx = static_cast<int>( pos.x + 0.5f ) - spr.originX;
-	int desty = static_cast<int>( pos.y + 0.5f ) - spr.originY;
 	frameIndex = frameIndex % spr.totalCount;
 	int frameX = frameIndex % spr.hCount;
 	int frameY = frameIndex / spr.hCount;
+
+	// At a render scale below 1 the sprite's shrunk copy is drawn at the scaled position instead
+	float scale = GetDrawScale();
+	if( scale != 1.0f )
+	{
+		const PixelData& scaled = m_vScaledSprites[m_renderScaleIndex][spriteId];
+		int width = scaled.width / spr.hCount;
+		int height = scaled.height / spr.vCount;
+		int scaledX = static_cast<int>( ( pos.x * scale ) + 0.5f ) - static_cast<int>( ( spr.originX * scale ) + 0.5f );
+		int scaledY = static_cast<int>( ( pos.y * scale ) + 0.5f ) - static_cast<int>( ( spr.originY * scale ) + 0.5f );
+
+		m_blitter.BlitPixels( scaled, ( frameX * width ) + ( scaled.width * frameY * height ), scaledX, scaledY, width, height, alphaMultiply, tint );
+		return;
+	}
+
+	int destx = static_cast<int>( pos.x + 0.5f ) - spr.originX;
+	int desty = static_cast<int>( pos.y + 0.5f ) - spr.originY;
 	int pixelX = frameX * spr.width;
 	int pixelY = frameY * spr.height;
 	int frameOffset = pixelX + ( spr.canvasBuffer.width * pixelY );
 
-	m_blitter.BlitPixels( spr.preMultAlpha, frameOffset, destx, desty, spr.width, spr.height, alphaMultiply );
+	m_blitter.BlitPixels( spr.preMultAlpha, frameOffset, destx, desty, spr.width, spr.height, alphaMultiply, tint );
 };
 
-void PlayGraphics::DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale, float alphaMultiply ) const
+void PlayGraphics::DrawRotated( int spriteId, Point2f pos, int frameIndex, float angle, float scale, float alphaMultiply, Pixel tint ) const
 {
 	Matrix2D trans =  MatrixScale( scale, scale ) * MatrixRotation( angle );
 	trans.row[2] = { pos.x, pos.y, 1.0f };
-	DrawTransformed( spriteId, trans, frameIndex, alphaMultiply );
+	DrawTransformed( spriteId, trans, frameIndex, alphaMultiply, tint );
 }
 
-void PlayGraphics::DrawTransformed( int spriteId, const Matrix2D& trans, int frameIndex, float alphaMultiply ) const
+void PlayGraphics::DrawTransformed( int spriteId, const Matrix2D& trans, int frameIndex, float alphaMultiply, Pixel tint ) const
 {
 	const Sprite& spr = vSpriteData[spriteId];
 	frameIndex = frameIndex % spr.totalCount;
@@ -3190,7 +4913,10 @@ void PlayGraphics::DrawTransformed( int spriteId, const Matrix2D& trans, int fra
 	int frameOffset = pixelX + ( spr.canvasBuffer.width * pixelY );
 
 	Vector2f origin = { spr.originX, spr.originY };
-	m_blitter.TransformPixels( spr.preMultAlpha, frameOffset, spr.width, spr.height, origin, trans, alphaMultiply );
+
+	// At a render scale below 1 the whole transformation is shrunk, so the full size sprite is just sampled less often
+	float scale = GetDrawScale();
+	m_blitter.TransformPixels( spr.preMultAlpha, frameOffset, spr.width, spr.height, origin, scale != 1.0f ? trans * MatrixScale( scale, scale ) : trans, alphaMultiply, tint );
 }
 
 
@@ -3198,72 +4924,547 @@ void PlayGraphics::DrawBackground( int backgroundId )
 {
 	PLAY_ASSERT_MSG( m_playBuffer.pPixels, "Trying to draw background without initialising display!" );
 	PLAY_ASSERT_MSG( vBackgroundData.size() > static_cast<size_t>(backgroundId), "Background image out of range!" );
-	m_blitter.BlitBackground( vBackgroundData[backgroundId] );
-}
+	PLAY_ASSERT_MSG( vBackgroundData[backgroundId].pPixels, "Trying to draw a background which has been unloaded!" );
 
-void PlayGraphics::ColourSprite( int spriteId, int r, int g, int b )
-{
-	PLAY_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to colour invalid sprite id" );
+	// At a render scale below 1 the background's shrunk copy is drawn instead
+	PixelData& background = GetDrawScale() != 1.0f ? m_vScaledBackgrounds[m_renderScaleIndex][backgroundId] : vBackgroundData[backgroundId];
+	const PixelData* pTarget = m_blitter.GetRenderTarget();
 
-	Sprite& s = vSpriteData[spriteId];
-	uint32_t col = ( ( r & 0xFF ) << 16 ) | ( ( g & 0xFF ) << 8 ) | ( b & 0xFF );
+	// A single memcpy is fastest when the background is an exact fit
+	if( !background.preMultiplied && background.width == pTarget->width && background.height == pTarget->height )
+	{
+		m_blitter.BlitBackground( background );
+		return;
+	}
 
-	PreMultiplyAlpha( s.canvasBuffer.pPixels, s.preMultAlpha.pPixels, s.canvasBuffer.width, s.canvasBuffer.height, s.width, 1.0f, col );
-	s.canvasBuffer.preMultiplied = true;
+	// The last frame would still be there wherever a smaller or transparent background doesn't cover it
+	if( background.preMultiplied || background.width < pTarget->width || background.height < pTarget->height )
+		m_blitter.ClearRenderTarget( PIX_BLACK );
+
+	m_blitter.BlitBackground( background, 0, 0, false );
 }
 
-int PlayGraphics::DrawString( int fontId, Point2f pos, std::string text ) const
+int PlayGraphics::AddBackgroundLayer( int backgroundId, float scrollFactor, bool tile )
 {
-	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
+	PLAY_ASSERT_MSG( vBackgroundData.size() > static_cast<size_t>( backgroundId ) && backgroundId >= 0, "Background image out of range!" );
+	PLAY_ASSERT_MSG( vBackgroundData[backgroundId].pPixels, "Trying to add a background layer which has been unloaded!" );
+	m_vBackgroundLayers.push_back( { backgroundId, scrollFactor, tile } );
+	return static_cast<int>( m_vBackgroundLayers.size() ) - 1;
+}
 
-	int width = 0;
+void PlayGraphics::DrawBackgroundLayers( Point2f cameraPos ) const
+{
+	PLAY_ASSERT_MSG( m_playBuffer.pPixels, "Trying to draw background without initialising display!" );
 
-	for( char c : text )
+	// At a render scale below 1 the backgrounds' shrunk copies are scrolled by the scaled camera position
+	float scale = GetDrawScale();
+
+	for( const BackgroundLayer& layer : m_vBackgroundLayers )
 	{
-		Draw( fontId, { pos.x + width, pos.y }, c - 32 );
-		width += GetFontCharWidth( fontId, c );
+		int scrollX = static_cast<int>( floorf( cameraPos.x * layer.scrollFactor * scale ) );
+		int scrollY = static_cast<int>( floorf( cameraPos.y * layer.scrollFactor * scale ) );
+		const PixelData& background = scale != 1.0f ? m_vScaledBackgrounds[m_renderScaleIndex][layer.backgroundId] : vBackgroundData[layer.backgroundId];
+		m_blitter.BlitBackground( background, scrollX, scrollY, layer.tile );
 	}
-	return width;
 }
 
-int PlayGraphics::DrawStringCentred( int fontId, Point2f pos, std::string text ) const
-{
-	int totalWidth = 0;
+//********************************************************************************************************************************
+// Tilemap functions
+//********************************************************************************************************************************
 
-	for( char c : text )
-		totalWidth += GetFontCharWidth( fontId, c );
+int PlayGraphics::CreateTilemap( int spriteId, int columns, int rows )
+{
+	PLAY_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to create a tilemap with an invalid sprite id" );
+	PLAY_ASSERT_MSG( columns > 0 && rows > 0, "Tilemap must have at least one tile" );
 
-	pos.x -= totalWidth / 2;
+	Tilemap map;
+	map.spriteId = spriteId;
+	map.columns = columns;
+	map.rows = rows;
+	map.chunksX = ( columns + TILEMAP_CHUNK_SIZE - 1 ) / TILEMAP_CHUNK_SIZE;
+	map.chunksY = ( rows + TILEMAP_CHUNK_SIZE - 1 ) / TILEMAP_CHUNK_SIZE;
+	map.vTiles.assign( static_cast<size_t>( columns ) * rows, -1 );
+	map.vChunks.resize( static_cast<size_t>( map.chunksX ) * map.chunksY );
 
-	DrawString( fontId, pos, text );
-	return totalWidth;
+	m_vTilemaps.push_back( std::move( map ) );
+	return static_cast<int>( m_vTilemaps.size() ) - 1;
 }
 
-int PlayGraphics::DrawChar( int fontId, Point2f pos, char c ) const
+void PlayGraphics::DestroyTilemap( int tilemapId )
 {
-	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
-	Draw( fontId, { pos.x, pos.y }, c - 32 );
-	return GetFontCharWidth( fontId, c );
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ), "Trying to destroy invalid tilemap id" );
+
+	Tilemap& map = m_vTilemaps[tilemapId];
+	FreeTilemapChunks( map );
+	map = Tilemap();
 }
 
-int PlayGraphics::DrawCharRotated( int fontId, Point2f pos, float angle, float scale, char c ) const
+void PlayGraphics::SetTile( int tilemapId, int column, int row, int tileIndex )
 {
-	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
-	DrawRotated( fontId, { pos.x, pos.y }, c - 32, angle, scale );
-	return GetFontCharWidth( fontId, c );
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to use invalid tilemap id" );
+
+	Tilemap& map = m_vTilemaps[tilemapId];
+	PLAY_ASSERT_MSG( column >= 0 && column < map.columns && row >= 0 && row < map.rows, "Tile position outside of the tilemap" );
+	PLAY_ASSERT_MSG( tileIndex >= -1 && tileIndex < vSpriteData[map.spriteId].totalCount, "Tile index outside of the tilemap's sprite sheet" );
+
+	int16_t& tile = map.vTiles[column + ( row * map.columns )];
+
+	if( tile != tileIndex )
+	{
+		tile = static_cast<int16_t>( tileIndex );
+		map.vChunks[( column / TILEMAP_CHUNK_SIZE ) + ( ( row / TILEMAP_CHUNK_SIZE ) * map.chunksX )].dirty = true;
+	}
 }
 
-int PlayGraphics::GetFontCharWidth( int fontId, char c ) const
+int PlayGraphics::GetTile( int tilemapId, int column, int row ) const
 {
-	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
-	return (vSpriteData[fontId].canvasBuffer.pPixels + ( c - 32 ))->b; // character width hidden in pixel data
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to use invalid tilemap id" );
+
+	const Tilemap& map = m_vTilemaps[tilemapId];
+	if( column < 0 || column >= map.columns || row < 0 || row >= map.rows )
+		return -1;
+
+	return map.vTiles[column + ( row * map.columns )];
 }
 
+void PlayGraphics::SetTiles( int tilemapId, int column, int row, int width, int height, const int16_t* pTiles )
+{
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to use invalid tilemap id" );
 
+	Tilemap& map = m_vTilemaps[tilemapId];
+	PLAY_ASSERT_MSG( column >= 0 && row >= 0 && column + width <= map.columns && row + height <= map.rows, "Tiles outside of the tilemap" );
 
+	// Release builds carry on after an assert, so invalid tiles are left empty rather than drawn from beyond the sprite sheet
+	int tileCount = vSpriteData[map.spriteId].totalCount;
+	int invalidCount = 0;
 
-//********************************************************************************************************************************
-// Function:	SpriteCollide: function that checks by pixel if two sprites collide
+	for( int r = 0; r < height; r++ )
+	{
+		int16_t* pRow = &map.vTiles[column + ( ( row + r ) * map.columns )];
+		const int16_t* pSource = pTiles + ( r * width );
+
+		for( int c = 0; c < width; c++ )
+		{
+			bool valid = pSource[c] >= -1 && pSource[c] < tileCount;
+			pRow[c] = valid ? pSource[c] : -1;
+			invalidCount += valid ? 0 : 1;
+		}
+	}
+
+	PLAY_ASSERT_MSG( invalidCount == 0, "Tile index outside of the tilemap's sprite sheet" );
+	MarkTilemapChunksDirty( map, column, row, width, height );
+}
+
+void PlayGraphics::FillTiles( int tilemapId, int column, int row, int width, int height, int tileIndex )
+{
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to use invalid tilemap id" );
+
+	Tilemap& map = m_vTilemaps[tilemapId];
+	PLAY_ASSERT_MSG( column >= 0 && row >= 0 && column + width <= map.columns && row + height <= map.rows, "Tiles outside of the tilemap" );
+
+	for( int r = 0; r < height; r++ )
+	{
+		int16_t* pRow = &map.vTiles[column + ( ( row + r ) * map.columns )];
+		std::fill( pRow, pRow + width, static_cast<int16_t>( tileIndex ) );
+	}
+
+	MarkTilemapChunksDirty( map, column, row, width, height );
+}
+
+Vector2f PlayGraphics::GetTileSize( int tilemapId ) const
+{
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to use invalid tilemap id" );
+	return GetSpriteSize( m_vTilemaps[tilemapId].spriteId );
+}
+
+void PlayGraphics::MarkTilemapChunksDirty( Tilemap& map, int column, int row, int width, int height )
+{
+	if( width <= 0 || height <= 0 )
+		return;
+
+	for( int cy = row / TILEMAP_CHUNK_SIZE; cy <= ( row + height - 1 ) / TILEMAP_CHUNK_SIZE; cy++ )
+	{
+		for( int cx = column / TILEMAP_CHUNK_SIZE; cx <= ( column + width - 1 ) / TILEMAP_CHUNK_SIZE; cx++ )
+			map.vChunks[cx + ( cy * map.chunksX )].dirty = true;
+	}
+}
+
+void PlayGraphics::DrawTilemap( int tilemapId, Point2f pos )
+{
+	PLAY_ASSERT_MSG( tilemapId >= 0 && tilemapId < static_cast<int>( m_vTilemaps.size() ) && m_vTilemaps[tilemapId].spriteId != -1, "Trying to draw invalid tilemap id" );
+	PLAY_ASSERT_MSG( !PlayBlitter::GetThreadDrawList(), "Tilemaps can't be drawn while this thread is recording its drawing" );
+
+	Tilemap& map = m_vTilemaps[tilemapId];
+	const Sprite& spr = vSpriteData[map.spriteId];
+	const PixelData* pTarget = m_blitter.GetRenderTarget();
+
+	// At a render scale below 1 the chunks' shrunk copies are drawn instead (TILEMAP_CHUNK_SIZE is a multiple of 4, so they stay whole pixels)
+	float scale = GetDrawScale();
+	int chunkWidth = static_cast<int>( spr.width * TILEMAP_CHUNK_SIZE * scale );
+	int chunkHeight = static_cast<int>( spr.height * TILEMAP_CHUNK_SIZE * scale );
+	int mapX = static_cast<int>( floorf( pos.x * scale ) );
+	int mapY = static_cast<int>( floorf( pos.y * scale ) );
+
+	if( mapX >= pTarget->width || mapY >= pTarget->height )
+		return;
+
+	// Only visit the chunks which overlap the render target
+	int firstChunkX = std::max( ( -mapX ) / chunkWidth, 0 );
+	int firstChunkY = std::max( ( -mapY ) / chunkHeight, 0 );
+	int lastChunkX = std::min( ( pTarget->width - mapX ) / chunkWidth, map.chunksX - 1 );
+	int lastChunkY = std::min( ( pTarget->height - mapY ) / chunkHeight, map.chunksY - 1 );
+
+	for( int cy = firstChunkY; cy <= lastChunkY; cy++ )
+	{
+		for( int cx = firstChunkX; cx <= lastChunkX; cx++ )
+		{
+			TilemapChunk& chunk = map.vChunks[cx + ( cy * map.chunksX )];
+
+			if( chunk.dirty )
+				RebuildTilemapChunk( map, cx, cy );
+
+			if( chunk.empty )
+				continue;
+
+			int drawX = mapX + ( cx * chunkWidth );
+			int drawY = mapY + ( cy * chunkHeight );
+			const PixelData* pImage = chunk.opaque ? &chunk.canvas : &chunk.preMultAlpha;
+
+			if( scale != 1.0f )
+			{
+				// The shrunk copy is made the first time the chunk is drawn at this scale after it changes
+				if( chunk.scaledIndex != m_renderScaleIndex )
+				{
+					WaitForRender();
+					ScalePixelData( *pImage, chunk.scaled );
+					chunk.scaledIndex = m_renderScaleIndex;
+				}
+
+				pImage = &chunk.scaled;
+			}
+
+			if( chunk.opaque )
+				m_blitter.BlitBackground( *pImage, -drawX, -drawY, false );
+			else
+				m_blitter.BlitPixels( *pImage, 0, drawX, drawY, pImage->width, pImage->height, 1.0f );
+		}
+	}
+}
+
+void PlayGraphics::RebuildTilemapChunk( Tilemap& map, int chunkX, int chunkY )
+{
+	// The render thread may still be drawing the chunk's old canvas
+	WaitForRender();
+
+	TilemapChunk& chunk = map.vChunks[chunkX + ( chunkY * map.chunksX )];
+	const Sprite& spr = vSpriteData[map.spriteId];
+
+	// Chunks along the right and bottom edges may be smaller than the rest
+	int firstColumn = chunkX * TILEMAP_CHUNK_SIZE;
+	int firstRow = chunkY * TILEMAP_CHUNK_SIZE;
+	int columns = std::min( TILEMAP_CHUNK_SIZE, map.columns - firstColumn );
+	int rows = std::min( TILEMAP_CHUNK_SIZE, map.rows - firstRow );
+
+	bool empty = true;
+	for( int r = 0; r < rows && empty; r++ )
+	{
+		const int16_t* pRow = &map.vTiles[firstColumn + ( ( firstRow + r ) * map.columns )];
+		empty = std::all_of( pRow, pRow + columns, []( int16_t tile ) { return tile < 0; } );
+	}
+
+	// Empty chunks (e.g. parts of a streamed level which have been unloaded) give their memory back
+	if( empty )
+	{
+		delete[] chunk.canvas.pPixels;
+		delete[] chunk.preMultAlpha.pPixels;
+		delete[] chunk.scaled.pPixels;
+		chunk = TilemapChunk();
+		chunk.empty = true;
+		chunk.dirty = false;
+		return;
+	}
+
+	chunk.empty = false;
+
+	if( !chunk.canvas.pPixels )
+	{
+		chunk.canvas.width = columns * spr.width;
+		chunk.canvas.height = rows * spr.height;
+		chunk.canvas.pPixels = new Pixel[static_cast<size_t>( chunk.canvas.width ) * chunk.canvas.height];
+	}
+
+	bool opaque = true;
+
+	for( int r = 0; r < rows; r++ )
+	{
+		for( int c = 0; c < columns; c++ )
+		{
+			int tile = map.vTiles[( firstColumn + c ) + ( ( firstRow + r ) * map.columns )];
+			Pixel* pDest = chunk.canvas.pPixels + ( r * spr.height * chunk.canvas.width ) + ( c * spr.width );
+
+			if( tile < 0 )
+			{
+				for( int y = 0; y < spr.height; y++ )
+					memset( pDest + ( y * chunk.canvas.width ), 0, sizeof( Pixel ) * spr.width );
+
+				opaque = false;
+				continue;
+			}
+
+			// Find the tile's frame on the sprite canvas
+			int frameX = tile % spr.hCount;
+			int frameY = tile / spr.hCount;
+			const Pixel* pSrc = spr.canvasBuffer.pPixels + ( frameX * spr.width ) + ( frameY * spr.height * spr.canvasBuffer.width );
+
+			for( int y = 0; y < spr.height; y++ )
+			{
+				const Pixel* pSrcRow = pSrc + ( y * spr.canvasBuffer.width );
+				memcpy( pDest + ( y * chunk.canvas.width ), pSrcRow, sizeof( Pixel ) * spr.width );
+
+				if( opaque )
+					opaque = std::all_of( pSrcRow, pSrcRow + spr.width, []( const Pixel& p ) { return p.a == 0xFF; } );
+			}
+		}
+	}
+
+	chunk.opaque = opaque;
+
+	// Chunks with any transparency are drawn like a sprite, so they need the same pre-multiplied format
+	if( !opaque )
+	{
+		if( !chunk.preMultAlpha.pPixels )
+		{
+			chunk.preMultAlpha.width = chunk.canvas.width;
+			chunk.preMultAlpha.height = chunk.canvas.height;
+			chunk.preMultAlpha.pPixels = new Pixel[static_cast<size_t>( chunk.canvas.width ) * chunk.canvas.height];
+		}
+
+		PreMultiplyAlpha( chunk.canvas.pPixels, chunk.preMultAlpha.pPixels, chunk.canvas.width, chunk.canvas.height, chunk.canvas.width, 1.0f, 0x00FFFFFF );
+		chunk.preMultAlpha.preMultiplied = true;
+	}
+
+	chunk.scaledIndex = 0;
+	chunk.dirty = false;
+}
+
+void PlayGraphics::FreeTilemapChunks( Tilemap& map )
+{
+	WaitForRender();
+
+	for( TilemapChunk& chunk : map.vChunks )
+	{
+		delete[] chunk.canvas.pPixels;
+		delete[] chunk.preMultAlpha.pPixels;
+		delete[] chunk.scaled.pPixels;
+		chunk = TilemapChunk();
+	}
+}
+
+void PlayGraphics::ColourSprite( int spriteId, int r, int g, int b )
+{
+	PLAY_ASSERT_MSG( spriteId >= 0 && spriteId < m_nTotalSprites, "Trying to colour invalid sprite id" );
+
+	Sprite& s = vSpriteData[spriteId];
+	uint32_t col = ( ( r & 0xFF ) << 16 ) | ( ( g & 0xFF ) << 8 ) | ( b & 0xFF );
+
+	WaitForRender();
+
+	PreMultiplyAlpha( s.canvasBuffer.pPixels, s.preMultAlpha.pPixels, s.canvasBuffer.width, s.canvasBuffer.height, s.width, 1.0f, col );
+	s.canvasBuffer.preMultiplied = true;
+	RescaleSprite( spriteId );
+}
+
+int PlayGraphics::DrawString( int fontId, Point2f pos, std::string text ) const
+{
+	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
+
+	int width = 0;
+
+	for( char c : text )
+	{
+		Draw( fontId, { pos.x + width, pos.y }, c - 32 );
+		width += GetFontCharWidth( fontId, c );
+	}
+	return width;
+}
+
+int PlayGraphics::DrawStringCentred( int fontId, Point2f pos, std::string text ) const
+{
+	int totalWidth = 0;
+
+	for( char c : text )
+		totalWidth += GetFontCharWidth( fontId, c );
+
+	pos.x -= totalWidth / 2;
+
+	DrawString( fontId, pos, text );
+	return totalWidth;
+}
+
+int PlayGraphics::DrawChar( int fontId, Point2f pos, char c ) const
+{
+	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
+	Draw( fontId, { pos.x, pos.y }, c - 32 );
+	return GetFontCharWidth( fontId, c );
+}
+
+int PlayGraphics::DrawCharRotated( int fontId, Point2f pos, float angle, float scale, char c ) const
+{
+	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
+	DrawRotated( fontId, { pos.x, pos.y }, c - 32, angle, scale );
+	return GetFontCharWidth( fontId, c );
+}
+
+int PlayGraphics::GetFontCharWidth( int fontId, char c ) const
+{
+	PLAY_ASSERT_MSG( fontId >= 0 && fontId < m_nTotalSprites, "Trying to use invalid sprite id for font" );
+	return (vSpriteData[fontId].canvasBuffer.pPixels + ( c - 32 ))->b; // character width hidden in pixel data
+}
+
+//********************************************************************************************************************************
+// Render layer functions
+//********************************************************************************************************************************
+
+int PlayGraphics::CreateRenderLayer( int width, int height )
+{
+	PLAY_ASSERT_MSG( width > 0 && height > 0, "Render layer must be at least one pixel in size" );
+
+	RenderLayer layer;
+	layer.canvas.width = width;
+	layer.canvas.height = height;
+	layer.canvas.pPixels = new Pixel[static_cast<size_t>( width ) * height];
+	layer.canvas.preMultiplied = true;
+
+	m_vRenderLayers.push_back( layer );
+	return static_cast<int>( m_vRenderLayers.size() ) - 1;
+}
+
+void PlayGraphics::DestroyRenderLayer( int layerId )
+{
+	PLAY_ASSERT_MSG( layerId >= 0 && layerId < static_cast<int>( m_vRenderLayers.size() ) && m_vRenderLayers[layerId].canvas.pPixels, "Trying to destroy invalid render layer id" );
+	PLAY_ASSERT_MSG( layerId != m_drawingLayer, "Trying to destroy a render layer while drawing into it" );
+
+	// The render thread may still be drawing the layer
+	WaitForRender();
+
+	delete[] m_vRenderLayers[layerId].canvas.pPixels;
+	delete[] m_vRenderLayers[layerId].scaled.pPixels;
+	m_vRenderLayers[layerId] = RenderLayer();
+}
+
+void PlayGraphics::SetRenderLayerDirty( int layerId )
+{
+	PLAY_ASSERT_MSG( layerId >= 0 && layerId < static_cast<int>( m_vRenderLayers.size() ) && m_vRenderLayers[layerId].canvas.pPixels, "Trying to use invalid render layer id" );
+	m_vRenderLayers[layerId].dirty = true;
+}
+
+bool PlayGraphics::IsRenderLayerDirty( int layerId ) const
+{
+	PLAY_ASSERT_MSG( layerId >= 0 && layerId < static_cast<int>( m_vRenderLayers.size() ) && m_vRenderLayers[layerId].canvas.pPixels, "Trying to use invalid render layer id" );
+	return m_vRenderLayers[layerId].dirty;
+}
+
+void PlayGraphics::BeginRenderLayer( int layerId )
+{
+	PLAY_ASSERT_MSG( layerId >= 0 && layerId < static_cast<int>( m_vRenderLayers.size() ) && m_vRenderLayers[layerId].canvas.pPixels, "Trying to draw into invalid render layer id" );
+	PLAY_ASSERT_MSG( m_drawingLayer == -1, "Trying to begin a render layer before ending the last one" );
+	PLAY_ASSERT_MSG( !PlayBlitter::GetThreadDrawList(), "Render layers can't be drawn into while this thread is recording its drawing" );
+
+	// The drawing is recorded so that it can be done twice when the layer ends
+	m_drawingLayer = layerId;
+	m_vLayerCommands.clear();
+	m_pLayerOldTarget = m_blitter.SetRenderTarget( &m_vRenderLayers[layerId].canvas );
+	PlayBlitter::SetThreadDrawList( &m_vLayerCommands, 0 );
+}
+
+void PlayGraphics::EndRenderLayer()
+{
+	PLAY_ASSERT_MSG( m_drawingLayer != -1, "Trying to end a render layer without beginning one" );
+
+	PlayBlitter::SetThreadDrawList( nullptr, 0 );
+	RenderLayer& layer = m_vRenderLayers[m_drawingLayer];
+
+	// The render thread may still be drawing the layer's old pixels
+	WaitForRender();
+
+	// Each pixel drawn over white is lighter than the same pixel drawn over black by the amount of the background which shows through
+	m_blitter.ClearRenderTarget( 0xFFFFFFFF );
+	m_blitter.ExecuteDrawList( m_vLayerCommands );
+	m_vLayerOverWhite.assign( layer.canvas.pPixels, layer.canvas.pPixels + ( layer.canvas.width * layer.canvas.height ) );
+
+	m_blitter.ClearRenderTarget( 0xFF000000 );
+	m_blitter.ExecuteDrawList( m_vLayerCommands );
+	EncodeRenderLayer( layer.canvas, m_vLayerOverWhite.data() );
+
+	m_blitter.SetRenderTarget( m_pLayerOldTarget );
+	layer.scaledIndex = 0;
+	layer.dirty = false;
+	m_drawingLayer = -1;
+}
+
+void PlayGraphics::DrawRenderLayer( int layerId, Point2f pos, float alphaMultiply )
+{
+	PLAY_ASSERT_MSG( layerId >= 0 && layerId < static_cast<int>( m_vRenderLayers.size() ) && m_vRenderLayers[layerId].canvas.pPixels, "Trying to draw invalid render layer id" );
+	PLAY_ASSERT_MSG( layerId != m_drawingLayer, "Trying to draw a render layer into itself" );
+	PLAY_ASSERT_MSG( !PlayBlitter::GetThreadDrawList(), "Render layers can't be drawn while this thread is recording its drawing" );
+
+	RenderLayer& layer = m_vRenderLayers[layerId];
+	const PixelData* pCanvas = &layer.canvas;
+	float scale = GetDrawScale();
+
+	if( scale != 1.0f )
+	{
+		// The shrunk copy is made the first time the layer is drawn at this scale after it changes
+		if( layer.scaledIndex != m_renderScaleIndex )
+		{
+			WaitForRender();
+			ScalePixelData( layer.canvas, layer.scaled );
+			layer.scaledIndex = m_renderScaleIndex;
+		}
+
+		pCanvas = &layer.scaled;
+	}
+
+	m_blitter.BlitPixels( *pCanvas, 0, static_cast<int>( floorf( pos.x * scale ) ), static_cast<int>( floorf( pos.y * scale ) ), pCanvas->width, pCanvas->height, alphaMultiply );
+}
+
+void PlayGraphics::EncodeRenderLayer( PixelData& canvas, const Pixel* pOverWhite )
+{
+	for( int y = 0; y < canvas.height; y++ )
+	{
+		Pixel* pRow = canvas.pPixels + ( y * canvas.width );
+		const Pixel* pWhiteRow = pOverWhite + ( y * canvas.width );
+		int transparentRun = 0;
+
+		// Working backwards along each row counts the transparent pixels which follow each transparent pixel, as PreMultiplyAlpha does
+		for( int x = canvas.width - 1; x >= 0; x-- )
+		{
+			uint32_t black = pRow[x].bits;
+			uint32_t white = pWhiteRow[x].bits;
+			int invAlpha = ( static_cast<int>( ( white >> 16 ) & 0xFF ) - static_cast<int>( ( black >> 16 ) & 0xFF )
+				+ static_cast<int>( ( white >> 8 ) & 0xFF ) - static_cast<int>( ( black >> 8 ) & 0xFF )
+				+ static_cast<int>( white & 0xFF ) - static_cast<int>( black & 0xFF ) ) / 3;
+
+			if( invAlpha >= 0xFF )
+			{
+				pRow[x].bits = 0xFF000000 | transparentRun;
+				transparentRun++;
+			}
+			else
+			{
+				// Drawn over black, the colour is already multiplied by its alpha
+				pRow[x].bits = ( std::max( invAlpha, 0 ) << 24 ) | ( black & 0x00FFFFFF );
+				transparentRun = 0;
+			}
+		}
+	}
+}
+
+
+
+
+//********************************************************************************************************************************
+// Function:	SpriteCollide: function that checks by pixel if two sprites collide
 // Parameters:	s1Xpos, s1Ypos, s2Xpos, s2Ypos = the origin of rotation for both sprites.
 //				s1Id, s2Id = the ids of both sprites
 //				s1angle, s2angle = the angle of rotation for both sprites, clockwise. 0 = unrotated.
@@ -3461,37 +5662,195 @@ bool PlayGraphics::SpriteCollide( int id_1, Point2f pos_1, int frame_1, float an
 	return false;
 }
 
+void PlayGraphics::BuildCollisionMask( Sprite& s )
+{
+	s.maskStride = ( s.width + 63 ) / 64;
+	s.vCollisionMask.assign( static_cast<size_t>( s.maskStride ) * s.height * s.totalCount, 0 );
+
+	for( int frame = 0; frame < s.totalCount; frame++ )
+	{
+		const Pixel* pFrame = s.canvasBuffer.pPixels + ( ( frame % s.hCount ) * s.width ) + ( ( frame / s.hCount ) * s.height * s.canvasBuffer.width );
+		uint64_t* pMaskRow = s.vCollisionMask.data() + static_cast<size_t>( frame ) * s.height * s.maskStride;
+
+		for( int y = 0; y < s.height; y++ )
+		{
+			const Pixel* pRow = pFrame + ( y * s.canvasBuffer.width );
+
+			// The same test as SpriteCollide: any alpha at all counts as solid
+			for( int x = 0; x < s.width; x++ )
+			{
+				if( pRow[x].bits > 0x00FFFFFF )
+					pMaskRow[x >> 6] |= 1ull << ( x & 63 );
+			}
+
+			pMaskRow += s.maskStride;
+		}
+	}
+}
+
+uint64_t PlayGraphics::GetMaskBits( const uint64_t* pRow, int stride, int firstBit )
+{
+	int word = firstBit >> 6; // Rounds down for negative bits too
+	int shift = firstBit & 63;
 
+	uint64_t lo = ( word >= 0 && word < stride ) ? pRow[word] : 0;
+	uint64_t hi = ( word + 1 >= 0 && word + 1 < stride ) ? pRow[word + 1] : 0;
 
+	return shift ? ( lo >> shift ) | ( hi << ( 64 - shift ) ) : lo;
+}
 
 //********************************************************************************************************************************
-// Function:	PreMultiplyAlpha - calculates the (src*srcAlpha) alpha blending calculation in advance as it doesn't change
-// Parameters:	s = the sprite to pre-calculate data for
-// Notes:		Also inverts the alpha ready for the (dest*(1-srcAlpha)) calculation and stores information in the new
-//				buffer which provides the number of fully-transparent pixels in a row (so they can be skipped)
+// Function:	MaskCollide: checks whether the solid pixels of two sprite frames overlap using their collision masks
+// Parameters:	s1Pos, s2Pos = the origins of both sprites, which are also their centres of rotation
+//				s1Angle, s2Angle = the angle of rotation for both sprites, clockwise. 0 = unrotated.
+// Notes:		If the angles are the same, sprite 2 is just shifted relative to sprite 1, so 64 pixels are tested at once.
+//				Otherwise each solid pixel of sprite 1 in the overlapping area is looked up in the mask of sprite 2 
 //********************************************************************************************************************************
-void PlayGraphics::PreMultiplyAlpha( Pixel* source, Pixel* dest, int width, int height, int maxSkipWidth, float alphaMultiply = 1.0f, Pixel colourMultiply = 0x00FFFFFF )
+bool PlayGraphics::MaskCollide( int id_1, Point2f pos_1, int frame_1, float angle_1, int id_2, Point2f pos_2, int frame_2, float angle_2 ) const
 {
-	Pixel* pSourcePixels = source;
-	Pixel* pDestPixels = dest;
+	PLAY_ASSERT_MSG( id_1 >= 0 && id_1 < m_nTotalSprites && id_2 >= 0 && id_2 < m_nTotalSprites, "Trying to use invalid sprite id" );
 
-	// Iterate through all the pixels in the entire canvas
-	for( int bh = 0; bh < height; bh++ )
-	{
-		for( int bw = 0; bw < width; bw++ )
-		{
-			Pixel src = *pSourcePixels;
+	const Sprite& s1 = vSpriteData[id_1];
+	const Sprite& s2 = vSpriteData[id_2];
 
-			// Separate the channels and calculate src*srcAlpha
-			int srcAlpha = static_cast<int>( ( src.bits >> 24 ) * alphaMultiply );
+	const uint64_t* pMask1 = s1.vCollisionMask.data() + static_cast<size_t>( frame_1 % s1.totalCount ) * s1.height * s1.maskStride;
+	const uint64_t* pMask2 = s2.vCollisionMask.data() + static_cast<size_t>( frame_2 % s2.totalCount ) * s2.height * s2.maskStride;
 
-			int destRed = ( srcAlpha * ( ( src.bits >> 16 ) & 0xFF ) ) >> 8;
-			int destGreen = ( srcAlpha * ( ( src.bits >> 8 ) & 0xFF ) ) >> 8;
-			int destBlue = ( srcAlpha * ( src.bits & 0xFF ) ) >> 8;
+	// Work in the pixels of sprite 1: find where the origin of sprite 2 is
+	float cosAngle1 = cos( angle_1 );
+	float sinAngle1 = sin( angle_1 );
+	float diffX = pos_2.x - pos_1.x;
+	float diffY = pos_2.y - pos_1.y;
+	float origin2U = ( diffX * cosAngle1 + diffY * sinAngle1 ) + s1.originX;
+	float origin2V = ( diffY * cosAngle1 - diffX * sinAngle1 ) + s1.originY;
 
-			destRed = ( destRed * ( ( colourMultiply.bits >> 16 ) & 0xFF ) ) >> 8;
-			destGreen = ( destGreen * ( ( colourMultiply.bits >> 8 ) & 0xFF ) ) >> 8;
-			destBlue = ( destBlue * ( colourMultiply.bits & 0xFF ) ) >> 8;
+	if( angle_1 == angle_2 )
+	{
+		// Sprite 2's top left corner in sprite 1's pixels
+		int offsetX = static_cast<int>( floor( origin2U - s2.originX + 0.5f ) );
+		int offsetY = static_cast<int>( floor( origin2V - s2.originY + 0.5f ) );
+
+		int minY = std::max( 0, offsetY );
+		int maxY = std::min( s1.height, offsetY + s2.height );
+		int minX = std::max( 0, offsetX );
+		int maxX = std::min( s1.width, offsetX + s2.width );
+
+		if( minX >= maxX || minY >= maxY )
+			return false;
+
+		for( int y = minY; y < maxY; y++ )
+		{
+			const uint64_t* pRow1 = pMask1 + y * s1.maskStride;
+			const uint64_t* pRow2 = pMask2 + ( y - offsetY ) * s2.maskStride;
+
+			// Sprite 2's mask is zero outside its width, so whole words of sprite 1 can be tested
+			for( int word = minX >> 6; word <= ( maxX - 1 ) >> 6; word++ )
+			{
+				if( pRow1[word] & GetMaskBits( pRow2, s2.maskStride, ( word << 6 ) - offsetX ) )
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	float cosAngleDiff = cos( angle_2 - angle_1 );
+	float sinAngleDiff = sin( angle_2 - angle_1 );
+
+	// Find the box around sprite 2 in sprite 1's pixels
+	float minU = std::numeric_limits<float>::infinity();
+	float minV = std::numeric_limits<float>::infinity();
+	float maxU = -std::numeric_limits<float>::infinity();
+	float maxV = -std::numeric_limits<float>::infinity();
+
+	for( int corner = 0; corner < 4; corner++ )
+	{
+		float a = ( ( corner & 1 ) ? s2.width : 0 ) - static_cast<float>( s2.originX );
+		float b = ( ( corner & 2 ) ? s2.height : 0 ) - static_cast<float>( s2.originY );
+		float u = origin2U + a * cosAngleDiff - b * sinAngleDiff;
+		float v = origin2V + a * sinAngleDiff + b * cosAngleDiff;
+		minU = std::min( minU, u );
+		maxU = std::max( maxU, u );
+		minV = std::min( minV, v );
+		maxV = std::max( maxV, v );
+	}
+
+	int minX = std::max( 0, static_cast<int>( floor( minU ) ) );
+	int maxX = std::min( s1.width, static_cast<int>( ceil( maxU ) ) );
+	int minY = std::max( 0, static_cast<int>( floor( minV ) ) );
+	int maxY = std::min( s1.height, static_cast<int>( ceil( maxV ) ) );
+
+	if( minX >= maxX || minY >= maxY )
+		return false;
+
+	for( int y = minY; y < maxY; y++ )
+	{
+		const uint64_t* pRow1 = pMask1 + y * s1.maskStride;
+
+		// Work through the row 64 pixels at a time, so the transparent parts of sprite 1 are skipped quickly
+		for( int x = minX; x < maxX; x += 64 )
+		{
+			uint64_t bits = GetMaskBits( pRow1, s1.maskStride, x );
+			if( maxX - x < 64 )
+				bits &= ( 1ull << ( maxX - x ) ) - 1;
+
+			for( int bit = 0; bits != 0; bit++, bits >>= 1 )
+			{
+				if( !( bits & 1 ) )
+					continue;
+
+				// Look up the centre of the pixel in sprite 2
+				float u = x + bit + 0.5f - origin2U;
+				float v = y + 0.5f - origin2V;
+				float a = u * cosAngleDiff + v * sinAngleDiff + s2.originX;
+				float b = v * cosAngleDiff - u * sinAngleDiff + s2.originY;
+
+				if( a >= 0.0f && b >= 0.0f && a < s2.width && b < s2.height )
+				{
+					int pixelA = static_cast<int>( a );
+					int pixelB = static_cast<int>( b );
+
+					if( pMask2[pixelB * s2.maskStride + ( pixelA >> 6 )] & ( 1ull << ( pixelA & 63 ) ) )
+						return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+
+
+
+//********************************************************************************************************************************
+// Function:	PreMultiplyAlpha - calculates the (src*srcAlpha) alpha blending calculation in advance as it doesn't change
+// Parameters:	s = the sprite to pre-calculate data for
+// Notes:		Also inverts the alpha ready for the (dest*(1-srcAlpha)) calculation and stores information in the new
+//				buffer which provides the number of fully-transparent pixels in a row (so they can be skipped)
+//********************************************************************************************************************************
+void PlayGraphics::PreMultiplyAlpha( Pixel* source, Pixel* dest, int width, int height, int maxSkipWidth, float alphaMultiply = 1.0f, Pixel colourMultiply = 0x00FFFFFF )
+{
+	Pixel* pSourcePixels = source;
+	Pixel* pDestPixels = dest;
+
+	// Iterate through all the pixels in the entire canvas
+	for( int bh = 0; bh < height; bh++ )
+	{
+		for( int bw = 0; bw < width; bw++ )
+		{
+			Pixel src = *pSourcePixels;
+
+			// Separate the channels and calculate src*srcAlpha
+			int srcAlpha = static_cast<int>( ( src.bits >> 24 ) * alphaMultiply );
+
+			int destRed = ( srcAlpha * ( ( src.bits >> 16 ) & 0xFF ) ) >> 8;
+			int destGreen = ( srcAlpha * ( ( src.bits >> 8 ) & 0xFF ) ) >> 8;
+			int destBlue = ( srcAlpha * ( src.bits & 0xFF ) ) >> 8;
+
+			destRed = ( destRed * ( ( colourMultiply.bits >> 16 ) & 0xFF ) ) >> 8;
+			destGreen = ( destGreen * ( ( colourMultiply.bits >> 8 ) & 0xFF ) ) >> 8;
+			destBlue = ( destBlue * ( colourMultiply.bits & 0xFF ) ) >> 8;
 
 			srcAlpha = 0xFF - srcAlpha; // invert the alpha ready to multiply with the destination pixels
 			*pDestPixels = ( srcAlpha << 24 ) | ( destRed << 16 ) | ( destGreen << 8 ) | destBlue;
@@ -3520,6 +5879,80 @@ void PlayGraphics::PreMultiplyAlpha( Pixel* source, Pixel* dest, int width, int
 	}
 }
 
+//********************************************************************************************************************************
+// Function:	ShrinkPixels - makes a smaller copy of a block of pixels with a box filter
+// Parameters:	pSrc, srcStride, srcWidth, srcHeight = the first pixel of the block, the width of the image it's in and its size
+//				pDest, destStride, destWidth, destHeight = the same for the block to fill, which must be no larger
+//				preMultiplied = whether the pixels are pre-multiplied (with runs of transparent pixels) or opaque
+// Notes:		Each new pixel is the average of the source pixels it covers, weighted by how much of each it covers. Pre-multiplied
+//				colours can be averaged as they are, and the runs of transparent pixels are counted again along each new row
+//********************************************************************************************************************************
+void PlayGraphics::ShrinkPixels( const Pixel* pSrc, int srcStride, int srcWidth, int srcHeight, Pixel* pDest, int destStride, int destWidth, int destHeight, bool preMultiplied )
+{
+	float ratioX = static_cast<float>( srcWidth ) / destWidth;
+	float ratioY = static_cast<float>( srcHeight ) / destHeight;
+
+	for( int dy = 0; dy < destHeight; dy++ )
+	{
+		float top = dy * ratioY;
+		float bottom = std::min( ( dy + 1 ) * ratioY, static_cast<float>( srcHeight ) );
+		Pixel* pDestRow = pDest + ( dy * destStride );
+
+		for( int dx = 0; dx < destWidth; dx++ )
+		{
+			float left = dx * ratioX;
+			float right = std::min( ( dx + 1 ) * ratioX, static_cast<float>( srcWidth ) );
+			float channels[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			float totalWeight = 0.0f;
+
+			for( int sy = static_cast<int>( top ); sy < bottom; sy++ )
+			{
+				float weightY = std::min( bottom, sy + 1.0f ) - std::max( top, static_cast<float>( sy ) );
+				const Pixel* pSrcRow = pSrc + ( sy * srcStride );
+
+				for( int sx = static_cast<int>( left ); sx < right; sx++ )
+				{
+					float weight = weightY * ( std::min( right, sx + 1.0f ) - std::max( left, static_cast<float>( sx ) ) );
+					uint32_t bits = pSrcRow[sx].bits;
+
+					// Transparent pixels store the length of their run rather than a colour
+					if( preMultiplied && ( bits >> 24 ) == 0xFF )
+						bits = 0xFF000000;
+
+					for( int c = 0; c < 4; c++ )
+						channels[c] += weight * ( ( bits >> ( c * 8 ) ) & 0xFF );
+
+					totalWeight += weight;
+				}
+			}
+
+			uint32_t bits = 0;
+			for( int c = 0; c < 4; c++ )
+				bits |= static_cast<uint32_t>( std::min( ( channels[c] / totalWeight ) + 0.5f, 255.0f ) ) << ( c * 8 );
+
+			pDestRow[dx].bits = bits;
+		}
+
+		if( preMultiplied )
+		{
+			int transparentRun = 0;
+
+			for( int dx = destWidth - 1; dx >= 0; dx-- )
+			{
+				if( ( pDestRow[dx].bits >> 24 ) == 0xFF )
+				{
+					pDestRow[dx].bits = 0xFF000000 | transparentRun;
+					transparentRun++;
+				}
+				else
+				{
+					transparentRun = 0;
+				}
+			}
+		}
+	}
+}
+
 //********************************************************************************************************************************
 // Basic drawing functions
 //********************************************************************************************************************************
@@ -3528,17 +5961,19 @@ void PlayGraphics::PreMultiplyAlpha( Pixel* source, Pixel* dest, int width, int
 
 void PlayGraphics::DrawPixel( Point2f pos, Pixel srcPix )
 {
-	// Convert floating point co-ordinates to pixels
-	m_blitter.DrawPixel( static_cast<int>( pos.x + 0.5f ), static_cast<int>( pos.y + 0.5f ), srcPix );
+	// Convert floating point co-ordinates to pixels (at the render scale)
+	float scale = GetDrawScale();
+	m_blitter.DrawPixel( static_cast<int>( ( pos.x * scale ) + 0.5f ), static_cast<int>( ( pos.y * scale ) + 0.5f ), srcPix );
 }
 
 void PlayGraphics::DrawLine( Point2f startPos, Point2f endPos, Pixel pix )
 {
-	// Convert floating point co-ordinates to pixels
-	int x1 = static_cast<int>( startPos.x + 0.5f );
-	int y1 = static_cast<int>( startPos.y + 0.5f );
-	int x2 = static_cast<int>( endPos.x + 0.5f );
-	int y2 = static_cast<int>( endPos.y + 0.5f );
+	// Convert floating point co-ordinates to pixels (at the render scale)
+	float scale = GetDrawScale();
+	int x1 = static_cast<int>( ( startPos.x * scale ) + 0.5f );
+	int y1 = static_cast<int>( ( startPos.y * scale ) + 0.5f );
+	int x2 = static_cast<int>( ( endPos.x * scale ) + 0.5f );
+	int y2 = static_cast<int>( ( endPos.y * scale ) + 0.5f );
 
 	m_blitter.DrawLine( x1, y1, x2, y2, pix );
 }
@@ -3548,11 +5983,12 @@ void PlayGraphics::DrawLine( Point2f startPos, Point2f endPos, Pixel pix )
 
 void PlayGraphics::DrawRect( Point2f topLeft, Point2f bottomRight, Pixel pix, bool fill )
 {
-	// Convert floating point co-ordinates to pixels
-	int x1 = static_cast<int>( topLeft.x + 0.5f );
-	int x2 = static_cast<int>( bottomRight.x + 0.5f );
-	int y1 = static_cast<int>( topLeft.y + 0.5f );
-	int y2 = static_cast<int>( bottomRight.y + 0.5f );
+	// Convert floating point co-ordinates to pixels (at the render scale)
+	float scale = GetDrawScale();
+	int x1 = static_cast<int>( ( topLeft.x * scale ) + 0.5f );
+	int x2 = static_cast<int>( ( bottomRight.x * scale ) + 0.5f );
+	int y1 = static_cast<int>( ( topLeft.y * scale ) + 0.5f );
+	int y2 = static_cast<int>( ( bottomRight.y * scale ) + 0.5f );
 
 	if( fill )
 	{
@@ -3574,21 +6010,24 @@ void PlayGraphics::DrawRect( Point2f topLeft, Point2f bottomRight, Pixel pix, bo
 // Private function called by DrawCircle
 void PlayGraphics::DrawCircleOctants( int posX, int posY, int offX, int offY, Pixel pix )
 {
-	DrawPixel( { posX + offX , posY + offY }, pix );
-	DrawPixel( { posX - offX , posY + offY }, pix );
-	DrawPixel( { posX + offX , posY - offY }, pix );
-	DrawPixel( { posX - offX , posY - offY }, pix );
-	DrawPixel( { posX - offY , posY + offX }, pix );
-	DrawPixel( { posX + offY , posY - offX }, pix );
-	DrawPixel( { posX - offY , posY - offX }, pix );
-	DrawPixel( { posX + offY , posY + offX }, pix );
+	// The centre is already in pixels at the render scale
+	m_blitter.DrawPixel( posX + offX, posY + offY, pix );
+	m_blitter.DrawPixel( posX - offX, posY + offY, pix );
+	m_blitter.DrawPixel( posX + offX, posY - offY, pix );
+	m_blitter.DrawPixel( posX - offX, posY - offY, pix );
+	m_blitter.DrawPixel( posX - offY, posY + offX, pix );
+	m_blitter.DrawPixel( posX + offY, posY - offX, pix );
+	m_blitter.DrawPixel( posX - offY, posY - offX, pix );
+	m_blitter.DrawPixel( posX + offY, posY + offX, pix );
 }
 
 void PlayGraphics::DrawCircle( Point2f pos, int radius, Pixel pix )
 {
-	// Convert floating point co-ordinates to pixels
-	int x = static_cast<int>( pos.x + 0.5f );
-	int y = static_cast<int>( pos.y + 0.5f );
+	// Convert floating point co-ordinates to pixels (at the render scale)
+	float scale = GetDrawScale();
+	int x = static_cast<int>( ( pos.x * scale ) + 0.5f );
+	int y = static_cast<int>( ( pos.y * scale ) + 0.5f );
+	radius = static_cast<int>( ( radius * scale ) + 0.5f );
 
 	int dx = 0;
 	int dy = radius;
@@ -3619,6 +6058,17 @@ void PlayGraphics::DrawPixelData( PixelData* pixelData, Point2f pos, float alpha
 		PreMultiplyAlpha( pixelData->pPixels, pixelData->pPixels, pixelData->width, pixelData->height, pixelData->width );
 		pixelData->preMultiplied = true;
 	}
+
+	float scale = GetDrawScale();
+	if( scale != 1.0f )
+	{
+		// Pixel data from outside doesn't have a shrunk copy, so it's drawn with a scaling transformation instead (which is slower)
+		Matrix2D transform = MatrixScale( scale, scale );
+		transform.row[2] = { pos.x * scale, pos.y * scale, 1.0f };
+		m_blitter.TransformPixels( *pixelData, 0, pixelData->width, pixelData->height, { 0.0f, 0.0f }, transform, alpha );
+		return;
+	}
+
 	m_blitter.BlitPixels( *pixelData, 0, static_cast<int>(pos.x), static_cast<int>(pos.y), pixelData->width, pixelData->height, alpha );
 }
 
@@ -3680,6 +6130,14 @@ int PlayGraphics::DrawDebugCharacter( Point2f pos, char c, Pixel pix )
 	if( c < 0x30 || c > 0x5F )
 		return FONT_CHAR_WIDTH;
 
+	// Drawing it at the render scale would lose most of its pixels, so it's kept until the frame is full size
+	// > Threads recording their own drawing can't share the list, so they draw it at the render scale
+	if( GetDrawScale() != 1.0f && !PlayBlitter::GetThreadDrawList() )
+	{
+		m_vDebugCharacters[m_recordList].push_back( { pos, c, pix } );
+		return FONT_CHAR_WIDTH;
+	}
+
 	int sourceX = ( ( c - 0x30 ) % 16 ) * FONT_CHAR_WIDTH;
 	int sourceY = ( ( c - 0x30 ) / 16 ) * FONT_CHAR_HEIGHT;
 
@@ -3696,6 +6154,26 @@ int PlayGraphics::DrawDebugCharacter( Point2f pos, char c, Pixel pix )
 	return FONT_CHAR_WIDTH;
 }
 
+void PlayGraphics::DrawDebugCharacters( PixelData& dest, const std::vector< DebugCharacter >& vDebugCharacters ) const
+{
+	PlayBlitter blitter( &dest );
+
+	for( const DebugCharacter& ch : vDebugCharacters )
+	{
+		int sourceX = ( ( ch.c - 0x30 ) % 16 ) * FONT_CHAR_WIDTH;
+		int sourceY = ( ( ch.c - 0x30 ) / 16 ) * FONT_CHAR_HEIGHT;
+
+		for( int x = 0; x < FONT_CHAR_WIDTH; x++ )
+		{
+			for( int y = 0; y < FONT_CHAR_HEIGHT; y++ )
+			{
+				if( m_pDebugFontBuffer[( ( sourceY + y ) * FONT_IMAGE_WIDTH ) + ( sourceX + x )] > 0 )
+					blitter.DrawPixel( static_cast<int>( ch.pos.x + x + 0.5f ), static_cast<int>( ch.pos.y + y + 0.5f ), ch.pix );
+			}
+		}
+	}
+}
+
 int PlayGraphics::DrawDebugString( Point2f pos, const std::string& s, Pixel pix, bool centred )
 {
 	if( m_pDebugFontBuffer == nullptr )
@@ -3781,163 +6259,1222 @@ void PlayGraphics::TimingBarBegin( Pixel pix )
 	m_vTimings.clear();
 	SetTimingBarColour( pix );
 }
-//********************************************************************************************************************************
-// File:		PlaySpeaker.cpp
-// Description:	Implementation of a very simple audio manager using the MCI
-// Platform:	Windows
-// Notes:		Uses MP3 format. The Windows multimedia library is extremely basic, but very quick easy to work with. 
-//				Playback isn't always instantaneous and can trigger small frame glitches when StartSound is called. 
-//				Consider XAudio2 as a potential next step.
-//********************************************************************************************************************************
-
-
-// Instruct Visual Studio to link the multimedia library  
-#pragma comment(lib, "winmm.lib")
-
-PlayAudio* PlayAudio::s_pInstance = nullptr;
 
 //********************************************************************************************************************************
-// Constructor and destructor (private)
+// Pipelined rendering functions
 //********************************************************************************************************************************
-PlayAudio::PlayAudio( const char* path )
+
+void PlayGraphics::SetPipelinedRendering( bool enable )
 {
-	PLAY_ASSERT_MSG( !s_pInstance, "PlayAudio is a singleton class: multiple instances not allowed!" );
-	PLAY_ASSERT_MSG( std::filesystem::is_directory( path ), "Audio directory does not exist!" );
+	if( enable == m_bPipelined )
+		return;
 
-	// Iterate through the directory
-	for( auto& p : std::filesystem::directory_iterator( path ) )
+	if( enable )
 	{
-		// Switch everything to uppercase to avoid need to check case each time
-		std::string filename = p.path().string();
-		for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+		PLAY_ASSERT_MSG( m_blitter.GetRenderTarget() == &GetFrameBuffer(), "Pipelined rendering must be turned on while drawing to the display buffer" );
+		m_vDrawLists[m_recordList].clear();
+		m_blitter.SetDrawList( &m_vDrawLists[m_recordList] );
+		m_bRenderQuit = false;
+		m_renderThread = std::thread( &PlayGraphics::RenderThreadLoop, this );
+	}
+	else
+	{
+		WaitForRender();
 
-		// Only load .mp3 files
-		if( filename.find( ".MP3" ) != std::string::npos )
 		{
-			vSoundStrings.push_back( filename );
-			std::string command = "open \"" + filename + "\" type mpegvideo alias " + filename;
-			mciSendStringA( command.c_str(), NULL, 0, 0 );
+			std::lock_guard< std::mutex > lock( m_renderMutex );
+			m_bRenderQuit = true;
 		}
+		m_renderCondition.notify_all();
+		m_renderThread.join();
+
+		// Anything recorded since the last frame was submitted still needs drawing
+		PixelData* pOldTarget = m_blitter.SetRenderTarget( &GetFrameBuffer() );
+		m_blitter.SetDrawList( nullptr );
+		m_blitter.ExecuteDrawList( m_vDrawLists[m_recordList] );
+		m_blitter.SetRenderTarget( pOldTarget );
+		m_vDrawLists[m_recordList].clear();
 	}
 
-	s_pInstance = this;
+	m_bPipelined = enable;
 }
 
-PlayAudio::~PlayAudio( void )
+void PlayGraphics::SubmitFrame( void ( *pPresent )( const PixelData& displayBuffer ) )
 {
-	for( std::string& s : vSoundStrings )
+	std::chrono::steady_clock::time_point submitTime = std::chrono::steady_clock::now();
+
+	if( !m_bPipelined )
 	{
-		std::string command = "close " + s;
-		mciSendStringA( command.c_str(), NULL, 0, 0 );
+		m_pPresent = pPresent;
+		m_renderTime.store( 0.0f );
+		PresentFrame( submitTime, m_vDebugCharacters[m_recordList] );
+		m_vDebugCharacters[m_recordList].clear();
+		return;
 	}
 
-	s_pInstance = nullptr;
-}
+	// Only one frame is drawn at a time, so the game can't get more than one frame ahead
+	WaitForRender();
 
-//********************************************************************************************************************************
-// Instance access functions
-//********************************************************************************************************************************
+	{
+		std::lock_guard< std::mutex > lock( m_renderMutex );
+		m_recordList ^= 1;
+		m_pPresent = pPresent;
+		m_submitTime = submitTime;
+		m_bFrameSubmitted = true;
+	}
+	m_renderCondition.notify_all();
 
-PlayAudio& PlayAudio::Instance()
-{
-	PLAY_ASSERT_MSG( s_pInstance, "Trying to use PlayAudio without initialising it!" );
-	return *s_pInstance;
+	// The render thread has finished with the other list, so the next frame can be recorded into it
+	m_vDrawLists[m_recordList].clear();
+	m_vDebugCharacters[m_recordList].clear();
+	m_blitter.SetDrawList( &m_vDrawLists[m_recordList] );
 }
 
-PlayAudio& PlayAudio::Instance( const char* path )
+void PlayGraphics::WaitForRender()
 {
-	PLAY_ASSERT_MSG( !s_pInstance, "Trying to create multiple instances of singleton class!" );
-	s_pInstance = new PlayAudio( path );
-	return *s_pInstance;
-}
+	if( !m_bPipelined )
+		return;
 
-void PlayAudio::Destroy()
-{
-	PLAY_ASSERT_MSG( s_pInstance, "Trying to use destroy PlayAudio which hasn't been instanced!" );
-	delete s_pInstance;
-	s_pInstance = nullptr;
+	std::unique_lock< std::mutex > lock( m_renderMutex );
+	m_renderCondition.wait( lock, [this]() { return !m_bFrameSubmitted; } );
 }
 
-//********************************************************************************************************************************
-// Sound playing functions
-//********************************************************************************************************************************
-void PlayAudio::StartAudio( const char* name, bool bLoop )
+void PlayGraphics::PresentLastFrame()
 {
-	std::string filename( name );
-	for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+	// The render thread presents too, so it must be idle before the last frame can be relied on
+	WaitForRender();
 
-	// Iterate through the sound data 
-	for( std::string& s : vSoundStrings )
+	if( !m_pPresent )
+		return;
+
+	// Without the presenter thread the display buffer always holds the last frame presented, stretched to full size if it needed to be
+	if( !m_bThreadedPresent )
 	{
-		if( s.find( filename ) != std::string::npos )
-		{
-			std::string command = "play " + s + " from 0";
-			if( bLoop ) command += " repeat";
-			mciSendStringA( command.c_str(), NULL, 0, 0 );
+		m_pPresent( m_playBuffer );
+		return;
+	}
+
+	// The presenter's last buffer isn't reused until the next frame is submitted, so it can just be handed back to the presenter thread
+	// > Unless a newer frame is already waiting or being presented, which repaints the window anyway
+	{
+		std::lock_guard< std::mutex > lock( m_presentMutex );
+		if( m_readyBuffer >= 0 || m_presentingBuffer >= 0 || m_presentedBuffer < 0 )
 			return;
-		}
+
+		m_readyBuffer = m_presentedBuffer;
+		m_presentSubmitTimes[m_readyBuffer] = std::chrono::steady_clock::now();
 	}
-	PLAY_ASSERT_MSG( false, std::string( "Trying to play unknown sound effect: " + std::string( name ) ).c_str() );
+	m_presentCondition.notify_all();
 }
 
-void PlayAudio::StopAudio( const char* name )
+void PlayGraphics::RenderThreadLoop()
 {
-	std::string filename( name );
-	for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+	// The render thread has its own blitter, which only ever draws to the frame buffer (the display buffer or the scaled buffer)
+	PlayBlitter blitter;
 
-	// Iterate through the sound data 
-	for( std::string& s : vSoundStrings )
+	for( ;; )
 	{
-		if( s.find( filename ) != std::string::npos )
-		{
-			std::string command = "stop " + s;
-			mciSendStringA( command.c_str(), NULL, 0, 0 );
-			return;
-		}
-	}
-	PLAY_ASSERT_MSG( false, std::string( "Trying to stop unknown sound effect: " + std::string( name ) ).c_str() );
-}
-//********************************************************************************************************************************
-// File:		PlayInput.cpp
-// Description:	Manages keyboard and mouse input 
-// Platform:	Windows
-// Notes:		Obtains mouse data from PlayWindow via MouseData structure
-//********************************************************************************************************************************
+		std::unique_lock< std::mutex > lock( m_renderMutex );
+		m_renderCondition.wait( lock, [this]() { return m_bFrameSubmitted || m_bRenderQuit; } );
 
+		if( !m_bFrameSubmitted )
+			return;
 
-PlayInput* PlayInput::s_pInstance = nullptr;
+		const std::vector< PlayBlitter::DrawCommand >& vDrawList = m_vDrawLists[m_recordList ^ 1];
+		const std::vector< DebugCharacter >& vDebugCharacters = m_vDebugCharacters[m_recordList ^ 1];
+		std::chrono::steady_clock::time_point submitTime = m_submitTime;
+		blitter.SetRenderTarget( &GetFrameBuffer() );
+		lock.unlock();
 
-//********************************************************************************************************************************
-// Constructor and destructor (private)
-//********************************************************************************************************************************
-PlayInput::PlayInput( void )
-{
-	PLAY_ASSERT_MSG( !s_pInstance, "PlayInput is a singleton class: multiple instances not allowed!" );
-	s_pInstance = this;
-}
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		blitter.ExecuteDrawList( vDrawList );
+		m_renderTime.store( std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - begin ).count() );
+		PresentFrame( submitTime, vDebugCharacters );
 
-PlayInput::~PlayInput( void )
-{
-	s_pInstance = nullptr;
+		lock.lock();
+		m_bFrameSubmitted = false;
+		lock.unlock();
+		m_renderCondition.notify_all();
+	}
 }
 
 //********************************************************************************************************************************
-// Instance access functions
+// Presenter thread functions
 //********************************************************************************************************************************
 
-PlayInput& PlayInput::Instance()
+void PlayGraphics::SetThreadedPresent( bool enable )
 {
-	if( !s_pInstance )
-		s_pInstance = new PlayInput();
+	if( enable == m_bThreadedPresent )
+		return;
 
-	return *s_pInstance;
-}
+	// The render thread presents too, so it must be idle while the presenter changes
+	WaitForRender();
 
-void PlayInput::Destroy()
-{
-	if( s_pInstance )
-		delete s_pInstance;
-}
+	if( enable )
+	{
+		for( PixelData& buffer : m_presentBuffers )
+		{
+			buffer.width = m_playBuffer.width;
+			buffer.height = m_playBuffer.height;
+			buffer.pPixels = new Pixel[static_cast<size_t>( buffer.width ) * buffer.height];
+			buffer.preMultiplied = false;
+		}
+
+		m_readyBuffer = -1;
+		m_presentingBuffer = -1;
+		m_presentedBuffer = -1;
+		m_bPresentQuit = false;
+		m_presentThread = std::thread( &PlayGraphics::PresenterThreadLoop, this );
+		m_bThreadedPresent = true;
+	}
+	else
+	{
+		m_bThreadedPresent = false;
+
+		// The presenter thread presents the frame waiting (if there is one) before it quits
+		{
+			std::lock_guard< std::mutex > lock( m_presentMutex );
+			m_bPresentQuit = true;
+		}
+		m_presentCondition.notify_all();
+		m_presentThread.join();
+
+		for( PixelData& buffer : m_presentBuffers )
+		{
+			delete[] buffer.pPixels;
+			buffer.pPixels = nullptr;
+		}
+	}
+}
+
+void PlayGraphics::PresentFrame( std::chrono::steady_clock::time_point submitTime, const std::vector< DebugCharacter >& vDebugCharacters )
+{
+	// A frame drawn at a lower resolution is stretched to fill the display buffer, or the presenter's copy of it
+	if( !m_bThreadedPresent )
+	{
+		if( m_renderScaleIndex )
+			UpscaleFrame( m_playBuffer );
+
+		DrawDebugCharacters( m_playBuffer, vDebugCharacters );
+		m_pPresent( m_playBuffer );
+		m_presentLatency.store( std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - submitTime ).count() );
+		return;
+	}
+
+	std::unique_lock< std::mutex > lock( m_presentMutex );
+	int buffer = 0;
+	while( buffer == m_readyBuffer || buffer == m_presentingBuffer )
+		buffer++;
+	lock.unlock();
+
+	// The presenter thread only ever takes the ready buffer, so this one can be filled without holding the lock
+	if( m_renderScaleIndex )
+		UpscaleFrame( m_presentBuffers[buffer] );
+	else
+		memcpy( m_presentBuffers[buffer].pPixels, m_playBuffer.pPixels, sizeof( Pixel ) * m_playBuffer.width * m_playBuffer.height );
+
+	DrawDebugCharacters( m_presentBuffers[buffer], vDebugCharacters );
+
+	lock.lock();
+	if( m_readyBuffer >= 0 )
+		m_framesDropped++;
+	m_readyBuffer = buffer;
+	m_presentSubmitTimes[buffer] = submitTime;
+	m_pPresenterFunction = m_pPresent;
+	lock.unlock();
+	m_presentCondition.notify_all();
+}
+
+void PlayGraphics::UpscaleFrame( PixelData& dest )
+{
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	PlayBlitter::UpscalePixels( m_scaledBuffer, dest, m_bSmoothUpscaling );
+	m_upscaleTime.store( std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - begin ).count() );
+}
+
+void PlayGraphics::PresenterThreadLoop()
+{
+	for( ;; )
+	{
+		std::unique_lock< std::mutex > lock( m_presentMutex );
+		m_presentCondition.wait( lock, [this]() { return m_readyBuffer >= 0 || m_bPresentQuit; } );
+
+		if( m_readyBuffer < 0 )
+			return;
+
+		int buffer = m_readyBuffer;
+		m_presentingBuffer = buffer;
+		m_readyBuffer = -1;
+		void ( *pPresent )( const PixelData& ) = m_pPresenterFunction;
+		std::chrono::steady_clock::time_point submitTime = m_presentSubmitTimes[buffer];
+		lock.unlock();
+
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		pPresent( m_presentBuffers[buffer] );
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+		m_presenterTime.store( std::chrono::duration<float, std::milli>( end - begin ).count() );
+		m_presentLatency.store( std::chrono::duration<float, std::milli>( end - submitTime ).count() );
+		m_framesPresented++;
+
+		lock.lock();
+		m_presentingBuffer = -1;
+		m_presentedBuffer = buffer;
+	}
+}
+
+//********************************************************************************************************************************
+// Threaded drawing functions
+//********************************************************************************************************************************
+
+void PlayGraphics::BeginThreadDrawing( uint32_t key, int layer )
+{
+	// Each thread adds a list of its own the first time it draws, and keeps using it for as long as the instance exists
+	thread_local std::vector< PlayBlitter::DrawCommand >* pThreadList = nullptr;
+	thread_local int listInstance = 0;
+
+	if( listInstance != m_instanceNumber )
+	{
+		std::lock_guard< std::mutex > lock( m_threadDrawMutex );
+		m_threadDrawLists.emplace_back();
+		pThreadList = &m_threadDrawLists.back();
+		listInstance = m_instanceNumber;
+	}
+
+	PlayBlitter::SetThreadDrawList( pThreadList, key );
+	PlayBlitter::SetThreadDrawLayer( layer );
+}
+
+void PlayGraphics::FlushThreadDrawing()
+{
+	m_mergedDrawList.clear();
+	for( std::vector< PlayBlitter::DrawCommand >& vThreadList : m_threadDrawLists )
+	{
+		m_mergedDrawList.insert( m_mergedDrawList.end(), vThreadList.begin(), vThreadList.end() );
+		vThreadList.clear();
+	}
+
+	if( m_mergedDrawList.empty() )
+		return;
+
+	// Commands with the same layer and key come from one thread, so a stable sort keeps them in the order they were recorded
+	std::stable_sort( m_mergedDrawList.begin(), m_mergedDrawList.end(), []( const PlayBlitter::DrawCommand& a, const PlayBlitter::DrawCommand& b )
+	{
+		return a.layer != b.layer ? a.layer < b.layer : a.key < b.key;
+	} );
+
+	m_blitter.ExecuteDrawList( m_mergedDrawList );
+}
+
+//********************************************************************************************************************************
+// Dynamic resolution functions
+//********************************************************************************************************************************
+
+void PlayGraphics::SetRenderScale( float scale )
+{
+	int scaleIndex = 0;
+	for( int i = 1; i < RENDER_SCALE_COUNT; i++ )
+	{
+		if( fabsf( RENDER_SCALES[i] - scale ) < fabsf( RENDER_SCALES[scaleIndex] - scale ) )
+			scaleIndex = i;
+	}
+
+	if( scaleIndex == m_renderScaleIndex )
+		return;
+
+	PLAY_ASSERT_MSG( m_drawingLayer == -1, "Trying to change the render scale while drawing into a render layer" );
+
+	// The render thread may still be drawing into the old frame buffer, or from the shrunk copies which are about to change
+	WaitForRender();
+
+	PixelData* pOldFrameBuffer = &GetFrameBuffer();
+
+	if( scaleIndex )
+	{
+		// The scaled buffer is allocated once, big enough for the largest of the scales below 1
+		if( !m_scaledBuffer.pPixels )
+		{
+			size_t width = static_cast<size_t>( ( m_playBuffer.width * RENDER_SCALES[1] ) + 0.5f );
+			size_t height = static_cast<size_t>( ( m_playBuffer.height * RENDER_SCALES[1] ) + 0.5f );
+			m_scaledBuffer.pPixels = new Pixel[width * height];
+			memset( m_scaledBuffer.pPixels, 0, sizeof( Pixel ) * width * height );
+		}
+
+		m_scaledBuffer.width = static_cast<int>( ( m_playBuffer.width * RENDER_SCALES[scaleIndex] ) + 0.5f );
+		m_scaledBuffer.height = static_cast<int>( ( m_playBuffer.height * RENDER_SCALES[scaleIndex] ) + 0.5f );
+	}
+	else
+	{
+		m_upscaleTime.store( 0.0f );
+	}
+
+	m_renderScaleIndex = scaleIndex;
+
+	if( scaleIndex )
+	{
+		// Sprites keep their shrunk copies for every scale they've been drawn at, so only new (or changed) sprites need shrinking
+		std::vector< PixelData >& vScaled = m_vScaledSprites[scaleIndex];
+		for( int id = 0; id < m_nTotalSprites; id++ )
+		{
+			if( id >= static_cast<int>( vScaled.size() ) || !vScaled[id].pPixels )
+				ScaleSprite( id, scaleIndex );
+		}
+
+		// The same goes for the backgrounds, which never change once they're loaded
+		for( int id = 0; id < static_cast<int>( vBackgroundData.size() ); id++ )
+		{
+			if( vBackgroundData[id].pPixels )
+				ScaleBackground( id );
+		}
+	}
+
+	// Anything drawing to the old frame buffer (including pipelined recording) moves to the new one
+	if( m_blitter.GetRenderTarget() == pOldFrameBuffer )
+	{
+		m_blitter.SetRenderTarget( &GetFrameBuffer() );
+		if( m_bPipelined )
+			m_blitter.SetDrawList( &m_vDrawLists[m_recordList] );
+	}
+}
+
+void PlayGraphics::SetDynamicResolution( bool enable, float frameBudget )
+{
+	PLAY_ASSERT_MSG( !enable || frameBudget > 0.0f, "Dynamic resolution needs a frame budget" );
+
+	m_bDynamicResolution = enable;
+	m_frameBudget = frameBudget;
+	m_frameTimeAverage = 0.0f;
+	m_settleFrames = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+}
+
+void PlayGraphics::UpdateDynamicResolution( float frameTime )
+{
+	if( !m_bDynamicResolution )
+		return;
+
+	m_frameTimeAverage += ( frameTime - m_frameTimeAverage ) * DYNAMIC_RESOLUTION_SMOOTHING;
+
+	if( m_settleFrames > 0 )
+	{
+		m_settleFrames--;
+		return;
+	}
+
+	int scaleIndex = m_renderScaleIndex;
+
+	if( m_frameTimeAverage > m_frameBudget * DYNAMIC_RESOLUTION_LOWER )
+	{
+		if( scaleIndex < RENDER_SCALE_COUNT - 1 )
+			scaleIndex++;
+	}
+	else if( scaleIndex > 0 )
+	{
+		// Assuming the whole frame time grows with the number of pixels overestimates it, which stops the scale bouncing back down
+		float growth = RENDER_SCALES[scaleIndex - 1] / RENDER_SCALES[scaleIndex];
+		if( m_frameTimeAverage * growth * growth < m_frameBudget * DYNAMIC_RESOLUTION_RAISE )
+			scaleIndex--;
+	}
+
+	if( scaleIndex != m_renderScaleIndex )
+	{
+		SetRenderScale( RENDER_SCALES[scaleIndex] );
+		m_settleFrames = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+	}
+}
+
+void PlayGraphics::ScaleSprite( int spriteId, int scaleIndex )
+{
+	const Sprite& spr = vSpriteData[spriteId];
+	std::vector< PixelData >& vScaled = m_vScaledSprites[scaleIndex];
+
+	if( spriteId >= static_cast<int>( vScaled.size() ) )
+		vScaled.resize( spriteId + 1 );
+
+	float scale = RENDER_SCALES[scaleIndex];
+	int frameWidth = std::max( static_cast<int>( ( spr.width * scale ) + 0.5f ), 1 );
+	int frameHeight = std::max( static_cast<int>( ( spr.height * scale ) + 0.5f ), 1 );
+
+	PixelData& scaled = vScaled[spriteId];
+	scaled.width = frameWidth * spr.hCount;
+	scaled.height = frameHeight * spr.vCount;
+	scaled.pPixels = new Pixel[static_cast<size_t>( scaled.width ) * scaled.height];
+	scaled.preMultiplied = true;
+
+	// Each frame is shrunk on its own so that neighbouring frames don't bleed into it
+	for( int frame = 0; frame < spr.totalCount; frame++ )
+	{
+		int frameX = frame % spr.hCount;
+		int frameY = frame / spr.hCount;
+		const Pixel* pSrc = spr.preMultAlpha.pPixels + ( frameX * spr.width ) + ( frameY * spr.height * spr.preMultAlpha.width );
+		Pixel* pDest = scaled.pPixels + ( frameX * frameWidth ) + ( frameY * frameHeight * scaled.width );
+		ShrinkPixels( pSrc, spr.preMultAlpha.width, spr.width, spr.height, pDest, scaled.width, frameWidth, frameHeight, true );
+	}
+}
+
+void PlayGraphics::RescaleSprite( int spriteId )
+{
+	for( std::vector< PixelData >& vScaled : m_vScaledSprites )
+	{
+		if( spriteId < static_cast<int>( vScaled.size() ) )
+		{
+			delete[] vScaled[spriteId].pPixels;
+			vScaled[spriteId] = PixelData();
+		}
+	}
+
+	if( m_renderScaleIndex )
+		ScaleSprite( spriteId, m_renderScaleIndex );
+}
+
+void PlayGraphics::ScaleBackground( int backgroundId )
+{
+	std::vector< PixelData >& vScaled = m_vScaledBackgrounds[m_renderScaleIndex];
+
+	if( backgroundId >= static_cast<int>( vScaled.size() ) )
+		vScaled.resize( backgroundId + 1 );
+
+	if( !vScaled[backgroundId].pPixels )
+		ScalePixelData( vBackgroundData[backgroundId], vScaled[backgroundId] );
+}
+
+void PlayGraphics::ScalePixelData( const PixelData& source, PixelData& scaled )
+{
+	float scale = RENDER_SCALES[m_renderScaleIndex];
+	int width = std::max( static_cast<int>( ( source.width * scale ) + 0.5f ), 1 );
+	int height = std::max( static_cast<int>( ( source.height * scale ) + 0.5f ), 1 );
+
+	if( !scaled.pPixels || scaled.width * scaled.height != width * height )
+	{
+		delete[] scaled.pPixels;
+		scaled.pPixels = new Pixel[static_cast<size_t>( width ) * height];
+	}
+
+	scaled.width = width;
+	scaled.height = height;
+	scaled.preMultiplied = source.preMultiplied;
+	ShrinkPixels( source.pPixels, source.width, source.width, source.height, scaled.pPixels, width, width, height, source.preMultiplied );
+}
+
+//********************************************************************************************************************************
+// File:		PlayStreamer.cpp
+// Description:	Streams a large tilemap level from disk in chunks around a focus point
+// Platform:	Independent
+// Notes:		Only the I/O thread touches the disk and only the game thread touches PlayGraphics. Chunk requests flow one
+//				way through a mutex-protected queue and loaded chunks flow back through a lock-free ring
+//********************************************************************************************************************************
+
+PlayStreamer* PlayStreamer::s_pInstance = nullptr;
+
+//********************************************************************************************************************************
+// Constructor and destructor (private)
+//********************************************************************************************************************************
+
+PlayStreamer::PlayStreamer()
+{
+	m_ioThread = std::thread( &PlayStreamer::IOThreadLoop, this );
+}
+
+PlayStreamer::~PlayStreamer()
+{
+	{
+		std::lock_guard< std::mutex > lock( m_requestMutex );
+		m_bQuit = true;
+	}
+	m_requestCondition.notify_one();
+	m_ioThread.join();
+
+	// Free up anything the I/O thread loaded which wasn't copied in
+	while( m_ringTail.load() != m_ringHead.load() )
+	{
+		int tail = m_ringTail.load();
+		delete m_ring[tail];
+		m_ringTail.store( ( tail + 1 ) % RING_SIZE );
+	}
+
+	if( m_tilemapId != -1 )
+		PlayGraphics::Instance().DestroyTilemap( m_tilemapId );
+}
+
+//********************************************************************************************************************************
+// Instance access functions
+//********************************************************************************************************************************
+
+PlayStreamer& PlayStreamer::Instance()
+{
+	if( !s_pInstance )
+		s_pInstance = new PlayStreamer();
+
+	return *s_pInstance;
+}
+
+void PlayStreamer::Destroy()
+{
+	if( s_pInstance )
+		delete s_pInstance;
+
+	s_pInstance = nullptr;
+}
+
+//********************************************************************************************************************************
+// Level streaming functions
+//********************************************************************************************************************************
+
+int PlayStreamer::OpenLevel( const char* path, int tileSpriteId, int columns, int rows, int chunkSize )
+{
+	PLAY_ASSERT_MSG( std::filesystem::is_directory( path ), "Streaming level directory does not exist!" );
+	PLAY_ASSERT_MSG( chunkSize > 0, "Streaming chunks must contain at least one tile" );
+
+	CloseLevel();
+
+	m_path = path;
+	m_columns = columns;
+	m_rows = rows;
+	m_chunkSize = chunkSize;
+	m_chunksX = ( columns + chunkSize - 1 ) / chunkSize;
+	m_chunksY = ( rows + chunkSize - 1 ) / chunkSize;
+	m_vChunkStates.assign( static_cast<size_t>( m_chunksX ) * m_chunksY, CHUNK_UNLOADED );
+	m_tilemapId = PlayGraphics::Instance().CreateTilemap( tileSpriteId, columns, rows );
+	m_tileSize = PlayGraphics::Instance().GetTileSize( m_tilemapId );
+	m_tileCount = PlayGraphics::Instance().GetSpriteFrames( tileSpriteId );
+
+	return m_tilemapId;
+}
+
+void PlayStreamer::CloseLevel()
+{
+	if( m_tilemapId == -1 )
+		return;
+
+	// Anything still on its way from the I/O thread will be ignored because it belongs to an old level
+	{
+		std::lock_guard< std::mutex > lock( m_requestMutex );
+		m_requests.clear();
+		m_levelId++;
+	}
+
+	PlayGraphics::Instance().DestroyTilemap( m_tilemapId );
+	m_tilemapId = -1;
+	m_vChunkStates.clear();
+	m_loadedCount = 0;
+	m_pendingCount = 0;
+	m_missingCount = 0;
+}
+
+void PlayStreamer::SetRadius( float loadRadius, float unloadRadius )
+{
+	PLAY_ASSERT_MSG( unloadRadius >= loadRadius, "The unload radius must be at least as large as the load radius" );
+	m_loadRadius = loadRadius;
+	m_unloadRadius = unloadRadius;
+}
+
+void PlayStreamer::Update( Point2f focus )
+{
+	if( m_tilemapId == -1 )
+		return;
+
+	PlayGraphics& graphics = PlayGraphics::Instance();
+	int levelId = m_levelId;
+
+	// Copy in the chunks which have finished loading (up to the budget) so a burst of loads is spread over several frames
+	for( int n = 0; n < m_budget && m_ringTail.load( std::memory_order_relaxed ) != m_ringHead.load( std::memory_order_acquire ); )
+	{
+		int tail = m_ringTail.load( std::memory_order_relaxed );
+		ChunkData* pChunk = m_ring[tail];
+		m_ringTail.store( ( tail + 1 ) % RING_SIZE, std::memory_order_release );
+
+		if( pChunk->levelId == levelId )
+		{
+			// A missing or corrupt file is streamed in as (partly) empty, but that shouldn't go unnoticed
+			if( pChunk->missing )
+			{
+				DebugOutput( "Missing level chunk: " + pChunk->path + "\n" );
+				m_missingCount++;
+			}
+			else if( pChunk->invalidCount > 0 )
+			{
+				DebugOutput( "Level chunk " + pChunk->path + " has " + std::to_string( pChunk->invalidCount ) + " tiles outside the sprite sheet\n" );
+			}
+
+			ChunkState& state = m_vChunkStates[pChunk->chunkX + ( pChunk->chunkY * m_chunksX )];
+
+			// The focus may have moved away while the chunk was loading
+			if( GetChunkDistance( pChunk->chunkX, pChunk->chunkY, focus ) <= m_unloadRadius )
+			{
+				int column, row, width, height;
+				GetChunkTiles( pChunk->chunkX, pChunk->chunkY, column, row, width, height );
+				graphics.SetTiles( m_tilemapId, column, row, width, height, pChunk->vTiles.data() );
+				state = CHUNK_LOADED;
+				m_loadedCount++;
+				n++;
+			}
+			else
+			{
+				state = CHUNK_UNLOADED;
+			}
+		}
+
+		delete pChunk;
+	}
+
+	// Requests which the I/O thread hasn't started yet are re-prioritised below, as the focus may have moved
+	{
+		std::lock_guard< std::mutex > lock( m_requestMutex );
+
+		for( ChunkRequest& request : m_requests )
+			m_vChunkStates[request.chunkX + ( request.chunkY * m_chunksX )] = CHUNK_UNLOADED;
+
+		m_requests.clear();
+	}
+
+	std::vector< std::pair< float, int > > vWanted;
+
+	for( int cy = 0; cy < m_chunksY; cy++ )
+	{
+		for( int cx = 0; cx < m_chunksX; cx++ )
+		{
+			ChunkState& state = m_vChunkStates[cx + ( cy * m_chunksX )];
+			float distance = GetChunkDistance( cx, cy, focus );
+
+			if( state == CHUNK_LOADED && distance > m_unloadRadius )
+			{
+				int column, row, width, height;
+				GetChunkTiles( cx, cy, column, row, width, height );
+				graphics.FillTiles( m_tilemapId, column, row, width, height, -1 );
+				state = CHUNK_UNLOADED;
+				m_loadedCount--;
+			}
+			else if( state == CHUNK_UNLOADED && distance <= m_loadRadius )
+			{
+				vWanted.push_back( { distance, cx + ( cy * m_chunksX ) } );
+			}
+		}
+	}
+
+	// Nearest chunks are loaded first, so the ones coming into view arrive before the ones being prefetched
+	std::sort( vWanted.begin(), vWanted.end() );
+	{
+		std::lock_guard< std::mutex > lock( m_requestMutex );
+
+		for( const std::pair< float, int >& wanted : vWanted )
+		{
+			int cx = wanted.second % m_chunksX;
+			int cy = wanted.second / m_chunksX;
+			m_vChunkStates[wanted.second] = CHUNK_REQUESTED;
+			std::filesystem::path chunkFile = std::filesystem::path( m_path ) / ( std::to_string( cx ) + "_" + std::to_string( cy ) + ".txt" );
+			m_requests.push_back( { cx, cy, levelId, m_tileCount, chunkFile.string() } );
+		}
+	}
+
+	if( !vWanted.empty() )
+		m_requestCondition.notify_one();
+
+	// Anything requested but not yet copied in (including chunks being loaded or waiting in the ring)
+	m_pendingCount = static_cast<int>( std::count( m_vChunkStates.begin(), m_vChunkStates.end(), CHUNK_REQUESTED ) );
+}
+
+//********************************************************************************************************************************
+// Internal functions
+//********************************************************************************************************************************
+
+void PlayStreamer::IOThreadLoop()
+{
+	for( ;; )
+	{
+		ChunkRequest request;
+		{
+			std::unique_lock< std::mutex > lock( m_requestMutex );
+			m_requestCondition.wait( lock, [this]() { return m_bQuit || !m_requests.empty(); } );
+
+			if( m_bQuit )
+				return;
+
+			request = m_requests.front();
+			m_requests.pop_front();
+		}
+
+		ChunkData* pChunk = new ChunkData;
+		pChunk->missing = !LoadChunk( request, *pChunk );
+
+		// Wait for the game thread to make room if it has fallen behind
+		int head = m_ringHead.load( std::memory_order_relaxed );
+		while( ( head + 1 ) % RING_SIZE == m_ringTail.load( std::memory_order_acquire ) )
+		{
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+			std::lock_guard< std::mutex > lock( m_requestMutex );
+			if( m_bQuit )
+			{
+				delete pChunk;
+				return;
+			}
+		}
+
+		m_ring[head] = pChunk;
+		m_ringHead.store( ( head + 1 ) % RING_SIZE, std::memory_order_release );
+	}
+}
+
+bool PlayStreamer::LoadChunk( const ChunkRequest& request, ChunkData& chunk ) const
+{
+	chunk.chunkX = request.chunkX;
+	chunk.chunkY = request.chunkY;
+	chunk.levelId = request.levelId;
+	chunk.path = request.path;
+
+	int column, row, width, height;
+	GetChunkTiles( request.chunkX, request.chunkY, column, row, width, height );
+	chunk.vTiles.assign( static_cast<size_t>( width ) * height, -1 );
+
+	std::ifstream chunkFile( request.path );
+	if( !chunkFile.is_open() )
+		return false;
+
+	int tile = -1;
+
+	for( int16_t& t : chunk.vTiles )
+	{
+		if( !( chunkFile >> tile ) )
+			break;
+
+		// A corrupt or out of date file mustn't make the tilemap draw from beyond the end of the sprite sheet
+		if( tile < -1 || tile >= request.tileCount )
+		{
+			chunk.invalidCount++;
+			continue;
+		}
+
+		t = static_cast<int16_t>( tile );
+	}
+
+	return true;
+}
+
+void PlayStreamer::GetChunkTiles( int chunkX, int chunkY, int& column, int& row, int& width, int& height ) const
+{
+	column = chunkX * m_chunkSize;
+	row = chunkY * m_chunkSize;
+	width = std::min( m_chunkSize, m_columns - column );
+	height = std::min( m_chunkSize, m_rows - row );
+}
+
+float PlayStreamer::GetChunkDistance( int chunkX, int chunkY, Point2f focus ) const
+{
+	float centreX = ( chunkX + 0.5f ) * m_chunkSize * m_tileSize.width;
+	float centreY = ( chunkY + 0.5f ) * m_chunkSize * m_tileSize.height;
+	return sqrtf( ( centreX - focus.x ) * ( centreX - focus.x ) + ( centreY - focus.y ) * ( centreY - focus.y ) );
+}
+
+//********************************************************************************************************************************
+// File:		PlayJobSystem.cpp
+// Description:	A pool of worker threads which share out small jobs by stealing them from each other's queues
+// Platform:	Independent
+// Notes:		The queues are Chase-Lev deques: the owner only needs a compare-and-swap when it and a thief go for the last
+//				job. A job which doesn't fit in a full queue is run straight away instead
+//********************************************************************************************************************************
+
+PlayJobSystem* PlayJobSystem::s_pInstance = nullptr;
+thread_local int PlayJobSystem::s_threadIndex = -1;
+
+//********************************************************************************************************************************
+// Constructor and destructor (private)
+//********************************************************************************************************************************
+
+PlayJobSystem::PlayJobSystem( int threadCount )
+{
+	if( threadCount <= 0 )
+		threadCount = std::max( static_cast<int>( std::thread::hardware_concurrency() ), 1 );
+
+	for( int i = 0; i < threadCount; i++ )
+		m_vQueues.push_back( new JobQueue );
+
+	// The creating thread is thread 0, which runs jobs while it waits for them
+	s_threadIndex = 0;
+
+	for( int i = 1; i < threadCount; i++ )
+		m_vThreads.push_back( std::thread( &PlayJobSystem::WorkerLoop, this, i ) );
+}
+
+PlayJobSystem::~PlayJobSystem()
+{
+	PLAY_ASSERT_MSG( m_pendingJobs.load() == 0, "Destroying the job system with jobs still waiting to run!" );
+
+	{
+		std::lock_guard< std::mutex > lock( m_sleepMutex );
+		m_bQuit = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for( std::thread& thread : m_vThreads )
+		thread.join();
+
+	for( JobQueue* pQueue : m_vQueues )
+		delete pQueue;
+
+	s_threadIndex = -1;
+}
+
+//********************************************************************************************************************************
+// Instance access functions
+//********************************************************************************************************************************
+
+PlayJobSystem& PlayJobSystem::Instance( int threadCount )
+{
+	PLAY_ASSERT_MSG( !s_pInstance, "Trying to create multiple instances of singleton class!" );
+	s_pInstance = new PlayJobSystem( threadCount );
+	return *s_pInstance;
+}
+
+PlayJobSystem& PlayJobSystem::Instance()
+{
+	if( !s_pInstance )
+		s_pInstance = new PlayJobSystem( 0 );
+
+	return *s_pInstance;
+}
+
+void PlayJobSystem::Destroy()
+{
+	if( s_pInstance )
+		delete s_pInstance;
+
+	s_pInstance = nullptr;
+}
+
+//********************************************************************************************************************************
+// Job functions
+//********************************************************************************************************************************
+
+void PlayJobSystem::Run( JobCounter& counter, JobFunction pFunction, void* pData, int begin, int end )
+{
+	PLAY_ASSERT_MSG( s_threadIndex >= 0, "Jobs can only be started by the thread which created the job system or by other jobs" );
+
+	Job job{ pFunction, pData, begin, end, &counter };
+	counter.count.fetch_add( 1 );
+
+	if( !m_vQueues[s_threadIndex]->Push( job ) )
+	{
+		Execute( job );
+		return;
+	}
+
+	m_pendingJobs.fetch_add( 1 );
+
+	// Only take the lock when there's a worker to wake (it holds the lock while deciding to sleep, so it can't miss this)
+	if( m_sleepingThreads.load() > 0 )
+	{
+		std::lock_guard< std::mutex > lock( m_sleepMutex );
+		m_wakeCondition.notify_one();
+	}
+}
+
+void PlayJobSystem::Wait( JobCounter& counter )
+{
+	PLAY_ASSERT_MSG( s_threadIndex >= 0, "Jobs can only be waited for by the thread which created the job system or by other jobs" );
+
+	while( counter.count.load() > 0 )
+	{
+		Job job;
+		if( FindJob( s_threadIndex, job ) )
+			Execute( job );
+		else
+			std::this_thread::yield();
+	}
+}
+
+void PlayJobSystem::ParallelFor( int count, JobFunction pFunction, void* pData, int grainSize )
+{
+	if( count <= 0 )
+		return;
+
+	// A few ranges per thread lets the threads which finish first steal from the ones which don't
+	if( grainSize <= 0 )
+		grainSize = std::max( count / ( GetThreadCount() * 4 ), 1 );
+
+	JobCounter counter;
+
+	// This thread takes the first range itself, after the rest have been made available to the others
+	for( int begin = grainSize; begin < count; begin += grainSize )
+		Run( counter, pFunction, pData, begin, std::min( begin + grainSize, count ) );
+
+	pFunction( pData, 0, std::min( grainSize, count ) );
+	Wait( counter );
+}
+
+//********************************************************************************************************************************
+// Worker functions (private)
+//********************************************************************************************************************************
+
+void PlayJobSystem::WorkerLoop( int threadIndex )
+{
+	s_threadIndex = threadIndex;
+
+	// Keep looking for a while before sleeping, as more jobs often arrive straight away
+	constexpr int SPIN_COUNT = 64;
+	int spins = 0;
+
+	for( ;; )
+	{
+		Job job;
+		if( FindJob( threadIndex, job ) )
+		{
+			Execute( job );
+			spins = 0;
+			continue;
+		}
+
+		if( ++spins < SPIN_COUNT )
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock< std::mutex > lock( m_sleepMutex );
+		m_sleepingThreads.fetch_add( 1 );
+		m_wakeCondition.wait( lock, [this]() { return m_pendingJobs.load() > 0 || m_bQuit; } );
+		m_sleepingThreads.fetch_sub( 1 );
+
+		if( m_bQuit && m_pendingJobs.load() == 0 )
+			return;
+
+		spins = 0;
+	}
+}
+
+bool PlayJobSystem::FindJob( int threadIndex, Job& job )
+{
+	bool found = m_vQueues[threadIndex]->Pop( job );
+
+	// Try the other threads in turn, starting with the next one along
+	int threads = GetThreadCount();
+	for( int i = 1; !found && i < threads; i++ )
+		found = m_vQueues[( threadIndex + i ) % threads]->Steal( job );
+
+	if( found )
+		m_pendingJobs.fetch_sub( 1 );
+
+	return found;
+}
+
+void PlayJobSystem::Execute( const Job& job )
+{
+	job.pFunction( job.pData, job.begin, job.end );
+	job.pCounter->count.fetch_sub( 1 );
+}
+
+//********************************************************************************************************************************
+// Job queue functions (private)
+//********************************************************************************************************************************
+
+bool PlayJobSystem::JobQueue::Push( const Job& job )
+{
+	int64_t b = bottom.load( std::memory_order_relaxed );
+	int64_t t = top.load( std::memory_order_acquire );
+
+	if( b - t >= CAPACITY )
+		return false;
+
+	jobs[b & ( CAPACITY - 1 )] = job;
+	bottom.store( b + 1, std::memory_order_release );
+	return true;
+}
+
+bool PlayJobSystem::JobQueue::Pop( Job& job )
+{
+	// Claim the back job before checking whether a thief has got to it first
+	int64_t b = bottom.load( std::memory_order_relaxed ) - 1;
+	bottom.store( b, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int64_t t = top.load( std::memory_order_relaxed );
+
+	if( t > b )
+	{
+		// Empty
+		bottom.store( b + 1, std::memory_order_relaxed );
+		return false;
+	}
+
+	job = jobs[b & ( CAPACITY - 1 )];
+
+	if( t < b )
+		return true;
+
+	// The last job: race any thieves for it
+	bool won = top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+	bottom.store( b + 1, std::memory_order_relaxed );
+	return won;
+}
+
+bool PlayJobSystem::JobQueue::Steal( Job& job )
+{
+	int64_t t = top.load( std::memory_order_acquire );
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	int64_t b = bottom.load( std::memory_order_acquire );
+
+	if( t >= b )
+		return false;
+
+	// If another thread takes this job first the slot may be reused while it's copied, but then the exchange fails and the copy is thrown away
+	job = jobs[t & ( CAPACITY - 1 )];
+	return top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+}
+
+//********************************************************************************************************************************
+// File:		PlaySpeaker.cpp
+// Description:	Implementation of a very simple audio manager using the MCI
+// Platform:	Windows
+// Notes:		Uses MP3 format. The Windows multimedia library is extremely basic, but very quick easy to work with. 
+//				Playback isn't always instantaneous and can trigger small frame glitches when StartSound is called. 
+//				Consider XAudio2 as a potential next step.
+//********************************************************************************************************************************
+
+
+// Instruct Visual Studio to link the multimedia library  
+#pragma comment(lib, "winmm.lib")
+
+PlayAudio* PlayAudio::s_pInstance = nullptr;
+
+//********************************************************************************************************************************
+// Constructor and destructor (private)
+//********************************************************************************************************************************
+PlayAudio::PlayAudio( const char* path )
+{
+	PLAY_ASSERT_MSG( !s_pInstance, "PlayAudio is a singleton class: multiple instances not allowed!" );
+	PLAY_ASSERT_MSG( std::filesystem::is_directory( path ), "Audio directory does not exist!" );
+
+	// Iterate through the directory
+	for( auto& p : std::filesystem::directory_iterator( path ) )
+	{
+		// Switch everything to uppercase to avoid need to check case each time
+		std::string filename = p.path().string();
+		for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+
+		// Only load .mp3 files
+		if( filename.find( ".MP3" ) != std::string::npos )
+		{
+			vSoundStrings.push_back( filename );
+			std::string command = "open \"" + filename + "\" type mpegvideo alias " + filename;
+			mciSendStringA( command.c_str(), NULL, 0, 0 );
+		}
+	}
+
+	s_pInstance = this;
+}
+
+PlayAudio::~PlayAudio( void )
+{
+	for( std::string& s : vSoundStrings )
+	{
+		std::string command = "close " + s;
+		mciSendStringA( command.c_str(), NULL, 0, 0 );
+	}
+
+	s_pInstance = nullptr;
+}
+
+//********************************************************************************************************************************
+// Instance access functions
+//********************************************************************************************************************************
+
+PlayAudio& PlayAudio::Instance()
+{
+	PLAY_ASSERT_MSG( s_pInstance, "Trying to use PlayAudio without initialising it!" );
+	return *s_pInstance;
+}
+
+PlayAudio& PlayAudio::Instance( const char* path )
+{
+	PLAY_ASSERT_MSG( !s_pInstance, "Trying to create multiple instances of singleton class!" );
+	s_pInstance = new PlayAudio( path );
+	return *s_pInstance;
+}
+
+void PlayAudio::Destroy()
+{
+	PLAY_ASSERT_MSG( s_pInstance, "Trying to use destroy PlayAudio which hasn't been instanced!" );
+	delete s_pInstance;
+	s_pInstance = nullptr;
+}
+
+//********************************************************************************************************************************
+// Sound playing functions
+//********************************************************************************************************************************
+void PlayAudio::StartAudio( const char* name, bool bLoop )
+{
+	std::string filename( name );
+	for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+
+	// Iterate through the sound data 
+	for( std::string& s : vSoundStrings )
+	{
+		if( s.find( filename ) != std::string::npos )
+		{
+			std::string command = "play " + s + " from 0";
+			if( bLoop ) command += " repeat";
+			mciSendStringA( command.c_str(), NULL, 0, 0 );
+			return;
+		}
+	}
+	PLAY_ASSERT_MSG( false, std::string( "Trying to play unknown sound effect: " + std::string( name ) ).c_str() );
+}
+
+void PlayAudio::StopAudio( const char* name )
+{
+	std::string filename( name );
+	for( char& c : filename ) c = static_cast<char>( toupper( c ) );
+
+	// Iterate through the sound data 
+	for( std::string& s : vSoundStrings )
+	{
+		if( s.find( filename ) != std::string::npos )
+		{
+			std::string command = "stop " + s;
+			mciSendStringA( command.c_str(), NULL, 0, 0 );
+			return;
+		}
+	}
+	PLAY_ASSERT_MSG( false, std::string( "Trying to stop unknown sound effect: " + std::string( name ) ).c_str() );
+}
+//********************************************************************************************************************************
+// File:		PlayInput.cpp
+// Description:	Manages keyboard and mouse input 
+// Platform:	Windows
+// Notes:		Obtains mouse data from PlayWindow via MouseData structure
+//********************************************************************************************************************************
+
+
+PlayInput* PlayInput::s_pInstance = nullptr;
+
+//********************************************************************************************************************************
+// Constructor and destructor (private)
+//********************************************************************************************************************************
+PlayInput::PlayInput( void )
+{
+	PLAY_ASSERT_MSG( !s_pInstance, "PlayInput is a singleton class: multiple instances not allowed!" );
+	s_pInstance = this;
+}
+
+PlayInput::~PlayInput( void )
+{
+	s_pInstance = nullptr;
+}
+
+//********************************************************************************************************************************
+// Instance access functions
+//********************************************************************************************************************************
+
+PlayInput& PlayInput::Instance()
+{
+	if( !s_pInstance )
+		s_pInstance = new PlayInput();
+
+	return *s_pInstance;
+}
+
+void PlayInput::Destroy()
+{
+	if( s_pInstance )
+		delete s_pInstance;
+}
 
 //********************************************************************************************************************************
 // Mouse functions
@@ -3992,13 +7529,474 @@ bool PlayInput::KeyDown( int vKey )
 
 // Constructor for the GameObject struct - kept as simple as possible
 GameObject::GameObject( int type, Point2f newPos, int collisionRadius, int spriteId = 0 )
-	: type( type ), pos( newPos ), radius( collisionRadius ), spriteId( spriteId )
+	: m_type( type ), pos( newPos ), radius( collisionRadius ), spriteId( spriteId )
 {
 	// Member variables are assigned default values in the class header
 	static int uniqueId = 0;
 	m_id = uniqueId++;
 }
 
+//**************************************************************************************************
+// GameObjectPool Class Definition
+//**************************************************************************************************
+
+// Stores the GameObjects in fixed-size pages so they never move, and identifies them with generational ids
+// > An id combines the index of the object's slot with a generation which changes every time the slot is reused,
+//   so the ids of destroyed objects don't find the new objects which take their place
+class GameObjectPool
+{
+public:
+	// The GameObject given is used to represent a missing object, so its id is set to -1
+	GameObjectPool( GameObject& noObject ) { noObject.m_id = -1; }
+	// Frees up all the pages of objects
+	~GameObjectPool();
+
+	// Creates a new object in a free slot and returns its id
+	int Create( int type, Point2f pos, int collisionRadius, int spriteId );
+	// Finds the object with the given id, or returns nullptr if it has been destroyed
+	GameObject* Find( int id );
+	// Destroys the object with the given id, returning false if it has already been destroyed
+	bool Destroy( int id );
+	// Destroys all the objects in constant time
+	void Clear();
+
+	// Gets the number of objects
+	int Count() const { return static_cast<int>( m_vDense.size() ); }
+	// Gets an object by its position in the packed list of objects (the order changes when objects are destroyed)
+	GameObject& GetByIndex( int denseIndex ) { return GetSlotObject( m_vDense[denseIndex] ); }
+	// Gets the index of the slot holding the object, or -1 if it isn't in the pool (e.g. noObject)
+	int IndexOf( const GameObject& obj ) { return Find( obj.m_id ) == &obj ? obj.m_id & INDEX_MASK : -1; }
+
+	// Per-type lists
+	//**************************************************************************************************
+
+	// Changes the type of an object and moves it to the list for its new type
+	void SetType( GameObject& obj, int type );
+	// Gets the number of objects of the given type
+	int CountOfType( int type ) const;
+	// Gets an object of the given type by its position in the type's list
+	GameObject& GetOfType( int type, int typeIndex ) { return GetSlotObject( m_typeLists.find( type )->second[typeIndex] ); }
+	// Calls a function for each object of the given type, iterating over a copy of their ids so the function can change the pool
+	void ForEachOfType( int type, void ( *pFunction )( GameObject& obj, void* pData ), void* pData );
+
+	// Deferred destruction
+	//**************************************************************************************************
+
+	// Queues an object to be destroyed when the queue is next flushed
+	void DestroyDeferred( int id ) { m_vDeferredDestroys.push_back( id ); }
+	// Destroys all the queued objects (ignoring any which have already been destroyed)
+	void FlushDeferred();
+
+	// Spatial hash
+	//**************************************************************************************************
+
+	// Records that a reference to an object has been handed out, so it may have moved by the next grid update
+	void Touch( GameObject& obj );
+	// Brings the spatial hash up to date, rebuilding it completely if the frame has changed since it was last built
+	// > Within a frame only the objects which have been handed out since the last update are moved between cells
+	void UpdateGrid( int frame );
+	// Sets the size of the cells in the spatial hash (which is rebuilt on the next update)
+	void SetGridCellSize( int cellSize );
+	// Calls the function with every object whose collision circle might overlap the given circle (call UpdateGrid first)
+	// > The function still needs to check whether the object is actually colliding
+	template< typename Function >
+	void ForEachNearby( Point2f pos, int radius, Function function );
+
+private:
+	// The number of objects allocated together, which keeps the objects mostly contiguous in memory
+	static constexpr int PAGE_SIZE = 256;
+	// The lower bits of an id are the slot index and the upper bits are the generation
+	static constexpr int INDEX_BITS = 20;
+	static constexpr int INDEX_MASK = ( 1 << INDEX_BITS ) - 1;
+	static constexpr int GENERATION_MASK = 0x7FF;
+
+	// Book-keeping for each slot, kept separate from the objects so the objects stay tightly packed
+	struct SlotInfo
+	{
+		int generation{ 0 };
+		int denseIndex{ -1 }; // Position in m_vDense, or -1 if the slot is free
+		int nextFree{ -1 }; // The next slot in the free list
+		int listType{ -1 }; // The type list the object is in
+		int listIndex{ -1 }; // Position in the type list
+		int cellX{ 0 }, cellY{ 0 }; // The spatial hash cell the object is in
+		int gridPrev{ -1 }, gridNext{ -1 }; // The neighbouring slots in the cell's bucket
+		bool inGrid{ false }; // Whether the slot is in a bucket of the spatial hash
+		bool moved{ false }; // Whether the slot is in m_vMoved
+	};
+
+	// The number of buckets the cells of the spatial hash are shared between (must be a power of two)
+	static constexpr int GRID_BUCKETS = 4096;
+
+	GameObject& GetSlotObject( int index ) { return m_vPages[index / PAGE_SIZE][index % PAGE_SIZE]; }
+	// Adds a slot to the end of the list for a type
+	void AddToTypeList( int index, int type );
+	// Removes a slot from its type list by moving the last slot in the list into its place
+	void RemoveFromTypeList( int index );
+	// Records that an object may have moved so its cell is checked on the next grid update
+	void MarkMoved( int index );
+	// Adds a slot to the bucket for the cell containing its object's position
+	void AddToGrid( int index );
+	// Removes a slot from its bucket
+	void RemoveFromGrid( int index );
+	// Gets the spatial hash cell coordinate for a position
+	int GridCell( float coord ) const { return static_cast<int>( floorf( coord / m_gridCellSize ) ); }
+	// Gets the bucket a cell belongs to
+	int GridBucket( int cellX, int cellY ) const { return static_cast<int>( ( static_cast<unsigned int>( cellX ) * 73856093u ) ^ ( static_cast<unsigned int>( cellY ) * 19349663u ) ) & ( GRID_BUCKETS - 1 ); }
+
+	std::vector< GameObject* > m_vPages;
+	std::vector< SlotInfo > m_vSlots;
+	// The slot indices of all the live objects, packed together for fast iteration
+	std::vector< int > m_vDense;
+	// The first slot in the list of destroyed slots which can be reused
+	int m_freeHead{ -1 };
+	// Slots at or above this index haven't been used since the pool was last cleared
+	int m_highWater{ 0 };
+	// The slot indices of the objects of each type
+	std::map< int, std::vector< int > > m_typeLists;
+	// The ids being iterated over by ForEachOfType (nested iterations add their ids to the end)
+	std::vector< int > m_vIterationIds;
+	// The ids of the objects waiting to be destroyed
+	std::vector< int > m_vDeferredDestroys;
+	// The first slot in each bucket of the spatial hash
+	std::vector< int > m_vGridHeads;
+	// The slots whose objects may have moved since the grid was last updated
+	std::vector< int > m_vMoved;
+	// The width and height of each cell in the spatial hash
+	int m_gridCellSize{ 64 };
+	// The frame the grid was last rebuilt on
+	int m_gridFrame{ -1 };
+	// The largest collision radius in the grid, which is how far queries have to look beyond their own circle
+	int m_gridMaxRadius{ 0 };
+};
+
+template< typename Function >
+void GameObjectPool::ForEachNearby( Point2f pos, int radius, Function function )
+{
+	int range = radius + m_gridMaxRadius;
+	int minX = GridCell( pos.x - range );
+	int maxX = GridCell( pos.x + range );
+	int minY = GridCell( pos.y - range );
+	int maxY = GridCell( pos.y + range );
+
+	// Very large queries are quicker to answer by checking every object
+	if( static_cast<long long>( maxX - minX + 1 ) * ( maxY - minY + 1 ) > Count() )
+	{
+		for( int index : m_vDense )
+		{
+			if( m_vSlots[index].inGrid )
+				function( GetSlotObject( index ) );
+		}
+		return;
+	}
+
+	for( int cellY = minY; cellY <= maxY; cellY++ )
+	{
+		for( int cellX = minX; cellX <= maxX; cellX++ )
+		{
+			for( int index = m_vGridHeads[GridBucket( cellX, cellY )]; index != -1; index = m_vSlots[index].gridNext )
+			{
+				// Other cells share the bucket, so skip their objects
+				if( m_vSlots[index].cellX == cellX && m_vSlots[index].cellY == cellY )
+					function( GetSlotObject( index ) );
+			}
+		}
+	}
+}
+
+GameObjectPool::~GameObjectPool()
+{
+	for( GameObject* pPage : m_vPages )
+		delete[] pPage;
+}
+
+int GameObjectPool::Create( int type, Point2f pos, int collisionRadius, int spriteId )
+{
+	int index;
+
+	if( m_freeHead != -1 )
+	{
+		index = m_freeHead;
+		m_freeHead = m_vSlots[index].nextFree;
+	}
+	else
+	{
+		index = m_highWater++;
+		PLAY_ASSERT_MSG( index <= INDEX_MASK, "Too many GameObjects!" );
+
+		if( index == static_cast<int>( m_vSlots.size() ) )
+		{
+			m_vPages.push_back( new GameObject[PAGE_SIZE] );
+			m_vSlots.resize( m_vSlots.size() + PAGE_SIZE );
+		}
+	}
+
+	// The generation changes whenever a slot is handed out so any old ids for the slot stop working
+	SlotInfo& slot = m_vSlots[index];
+	slot.generation = ( slot.generation + 1 ) & GENERATION_MASK;
+	slot.denseIndex = static_cast<int>( m_vDense.size() );
+	slot.nextFree = -1;
+	slot.inGrid = false;
+	m_vDense.push_back( index );
+
+	GameObject& obj = GetSlotObject( index );
+	obj = GameObject( type, pos, collisionRadius, spriteId );
+	obj.m_id = index | ( slot.generation << INDEX_BITS );
+	AddToTypeList( index, type );
+	MarkMoved( index );
+
+	return obj.m_id;
+}
+
+GameObject* GameObjectPool::Find( int id )
+{
+	int index = id & INDEX_MASK;
+
+	if( id < 0 || index >= m_highWater )
+		return nullptr;
+
+	const SlotInfo& slot = m_vSlots[index];
+
+	if( slot.denseIndex == -1 || slot.generation != ( ( id >> INDEX_BITS ) & GENERATION_MASK ) )
+		return nullptr;
+
+	return &GetSlotObject( index );
+}
+
+bool GameObjectPool::Destroy( int id )
+{
+	if( !Find( id ) )
+		return false;
+
+	int index = id & INDEX_MASK;
+	SlotInfo& slot = m_vSlots[index];
+
+	// Move the last live object into the gap so the packed list stays packed
+	int lastIndex = m_vDense.back();
+	m_vDense[slot.denseIndex] = lastIndex;
+	m_vSlots[lastIndex].denseIndex = slot.denseIndex;
+	m_vDense.pop_back();
+
+	RemoveFromTypeList( index );
+
+	if( slot.inGrid )
+		RemoveFromGrid( index );
+
+	// Mark the object as destroyed in case a reference to it is still being used
+	GetSlotObject( index ).m_type = -1;
+
+	slot.denseIndex = -1;
+	slot.nextFree = m_freeHead;
+	m_freeHead = index;
+
+	return true;
+}
+
+void GameObjectPool::Clear()
+{
+	// Every slot below the high water mark gets a new generation when it is next handed out and everything above it counts
+	// as free, so resetting the high water mark is enough to make every existing id stale
+	m_vDense.clear();
+	m_freeHead = -1;
+	m_highWater = 0;
+
+	for( std::pair< const int, std::vector< int > >& list : m_typeLists )
+		list.second.clear();
+
+	for( int index : m_vMoved )
+		m_vSlots[index].moved = false;
+
+	m_vMoved.clear();
+	m_vDeferredDestroys.clear();
+
+	// Every object has gone, so the buckets can simply be emptied
+	m_vGridHeads.assign( m_vGridHeads.size(), -1 );
+}
+
+void GameObjectPool::Touch( GameObject& obj )
+{
+	if( Find( obj.m_id ) != &obj )
+		return; // Not one of ours (e.g. noObject)
+
+	MarkMoved( obj.m_id & INDEX_MASK );
+}
+
+void GameObjectPool::SetType( GameObject& obj, int type )
+{
+	obj.m_type = type;
+
+	if( Find( obj.m_id ) != &obj )
+		return; // Not one of ours (e.g. noObject)
+
+	int index = obj.m_id & INDEX_MASK;
+	if( m_vSlots[index].listType != type )
+	{
+		RemoveFromTypeList( index );
+		AddToTypeList( index, type );
+	}
+}
+
+void GameObjectPool::ForEachOfType( int type, void ( *pFunction )( GameObject& obj, void* pData ), void* pData )
+{
+	// The ids are copied into a buffer which is reused every time, so nothing is allocated once it has grown large enough
+	size_t begin = m_vIterationIds.size();
+	std::map< int, std::vector< int > >::iterator it = m_typeLists.find( type );
+	if( it == m_typeLists.end() )
+		return;
+
+	for( int index : it->second )
+		m_vIterationIds.push_back( GetSlotObject( index ).m_id );
+
+	size_t end = m_vIterationIds.size();
+
+	for( size_t i = begin; i < end; i++ )
+	{
+		GameObject* pObj = Find( m_vIterationIds[i] );
+
+		// Skip objects which have been destroyed or changed type by an earlier call
+		if( !pObj || pObj->m_type != type )
+			continue;
+
+		// The function may move the object
+		Touch( *pObj );
+		pFunction( *pObj, pData );
+	}
+
+	m_vIterationIds.resize( begin );
+}
+
+void GameObjectPool::FlushDeferred()
+{
+	for( int id : m_vDeferredDestroys )
+		Destroy( id );
+
+	m_vDeferredDestroys.clear();
+}
+
+int GameObjectPool::CountOfType( int type ) const
+{
+	std::map< int, std::vector< int > >::const_iterator it = m_typeLists.find( type );
+	return it == m_typeLists.end() ? 0 : static_cast<int>( it->second.size() );
+}
+
+void GameObjectPool::AddToTypeList( int index, int type )
+{
+	std::vector< int >& list = m_typeLists[type];
+	m_vSlots[index].listType = type;
+	m_vSlots[index].listIndex = static_cast<int>( list.size() );
+	list.push_back( index );
+}
+
+void GameObjectPool::RemoveFromTypeList( int index )
+{
+	SlotInfo& slot = m_vSlots[index];
+	std::vector< int >& list = m_typeLists[slot.listType];
+
+	int lastIndex = list.back();
+	list[slot.listIndex] = lastIndex;
+	m_vSlots[lastIndex].listIndex = slot.listIndex;
+	list.pop_back();
+
+	slot.listType = -1;
+	slot.listIndex = -1;
+}
+
+void GameObjectPool::UpdateGrid( int frame )
+{
+	if( frame != m_gridFrame )
+	{
+		// References to objects can be kept between frames, so anything could have moved: start again from scratch
+		m_vGridHeads.assign( GRID_BUCKETS, -1 );
+		m_gridMaxRadius = 0;
+		m_gridFrame = frame;
+
+		for( int index : m_vDense )
+			AddToGrid( index );
+
+		for( int index : m_vMoved )
+			m_vSlots[index].moved = false;
+
+		m_vMoved.clear();
+		return;
+	}
+
+	for( int index : m_vMoved )
+	{
+		SlotInfo& slot = m_vSlots[index];
+		slot.moved = false;
+
+		if( slot.denseIndex == -1 )
+			continue; // Destroyed since it was marked
+
+		if( !slot.inGrid )
+		{
+			AddToGrid( index );
+			continue;
+		}
+
+		const GameObject& obj = GetSlotObject( index );
+		m_gridMaxRadius = std::max( m_gridMaxRadius, obj.radius );
+
+		if( GridCell( obj.pos.x ) != slot.cellX || GridCell( obj.pos.y ) != slot.cellY )
+		{
+			RemoveFromGrid( index );
+			AddToGrid( index );
+		}
+	}
+
+	m_vMoved.clear();
+}
+
+void GameObjectPool::SetGridCellSize( int cellSize )
+{
+	PLAY_ASSERT_MSG( cellSize > 0, "The grid cell size must be positive" );
+	m_gridCellSize = cellSize;
+	m_gridFrame = -1; // Forces a rebuild
+}
+
+void GameObjectPool::MarkMoved( int index )
+{
+	if( m_vSlots[index].moved )
+		return;
+
+	m_vSlots[index].moved = true;
+	m_vMoved.push_back( index );
+}
+
+void GameObjectPool::AddToGrid( int index )
+{
+	SlotInfo& slot = m_vSlots[index];
+	const GameObject& obj = GetSlotObject( index );
+
+	slot.cellX = GridCell( obj.pos.x );
+	slot.cellY = GridCell( obj.pos.y );
+	m_gridMaxRadius = std::max( m_gridMaxRadius, obj.radius );
+
+	int& head = m_vGridHeads[GridBucket( slot.cellX, slot.cellY )];
+	slot.gridPrev = -1;
+	slot.gridNext = head;
+
+	if( head != -1 )
+		m_vSlots[head].gridPrev = index;
+
+	head = index;
+	slot.inGrid = true;
+}
+
+void GameObjectPool::RemoveFromGrid( int index )
+{
+	SlotInfo& slot = m_vSlots[index];
+
+	if( slot.gridPrev != -1 )
+		m_vSlots[slot.gridPrev].gridNext = slot.gridNext;
+	else
+		m_vGridHeads[GridBucket( slot.cellX, slot.cellY )] = slot.gridNext;
+
+	if( slot.gridNext != -1 )
+		m_vSlots[slot.gridNext].gridPrev = slot.gridPrev;
+
+	slot.inGrid = false;
+}
+
 #endif
 
 // The PlayManager is namespace rather than a class
@@ -4006,12 +8004,12 @@ namespace Play
 {
 #ifdef PLAY_USING_GAMEOBJECT_MANAGER
 
-	// A map is used internally to store all the GameObjects and their unique ids
-	static std::map<int, GameObject&> objectMap;
-
 	// Used instead of Null return values, PlayMangager operations performed on this GameObject should fail transparently
 	static GameObject noObject{ -1,{ 0, 0 }, 0, -1 };
 
+	// A slot map is used internally to store all the GameObjects and look them up by their unique ids
+	static GameObjectPool objectPool( noObject );
+
 #endif 
 
 	// A set of default colour definitions
@@ -4027,6 +8025,12 @@ namespace Play
 	Colour cGrey{ 50.0f, 50.0f, 50.0f };
 
 	int frameCount = 0; // Updated in Play::Present
+	int simulationTick = 0; // Updated in Play::Present, or by Play::FixedUpdateStep when the fixed timestep is on
+
+	// The length of a simulation tick in seconds (0 when the fixed timestep is off) and the time waiting to be simulated
+	static float fixedTimestep = 0.0f;
+	static float fixedAccumulator = 0.0f;
+	static int fixedFrame = -1;
 
 	// The camera
 	Point2f cameraPos{ 0.0f, 0.0f };
@@ -4049,49 +8053,162 @@ namespace Play
 		srand( (int)time( NULL ) );
 	}
 
-	void DestroyManager()
+	void DestroyManager()
+	{
+		PlayStreamer::Destroy();
+		PlayJobSystem::Destroy();
+		PlayAudio::Destroy();
+		PlayGraphics::Destroy();
+		PlayWindow::Destroy();
+		PlayInput::Destroy();
+#ifdef PLAY_USING_GAMEOBJECT_MANAGER
+		objectPool.Clear();
+#endif
+	}
+
+	int GetBufferWidth()
+	{
+		return PlayWindow::Instance().GetWidth();
+	}
+
+	int GetBufferHeight()
+	{
+		return PlayWindow::Instance().GetHeight();
+	}
+
+	//**************************************************************************************************
+	// PlayGraphics functions
+	//**************************************************************************************************
+
+	void ClearDrawingBuffer( Colour c )
+	{
+		int r = static_cast<int>( c.red * 2.55f );
+		int g = static_cast<int>( c.green * 2.55f );
+		int b = static_cast<int>( c.blue * 2.55f );
+		PlayGraphics::Instance().ClearBuffer( { r, g, b } );
+	}
+
+	int LoadBackground( const char* pngFilename )
+	{
+		return PlayGraphics::Instance().LoadBackground( pngFilename );
+	}
+
+	void UnloadBackground( int background )
+	{
+		PlayGraphics::Instance().UnloadBackground( background );
+	}
+
+	void DrawBackground( int background )
+	{
+		PlayGraphics::Instance().DrawBackground( background );
+	}
+
+	int AddBackgroundLayer( int background, float scrollFactor, bool tile )
+	{
+		return PlayGraphics::Instance().AddBackgroundLayer( background, scrollFactor, tile );
+	}
+
+	void ClearBackgroundLayers( void )
+	{
+		PlayGraphics::Instance().ClearBackgroundLayers();
+	}
+
+	int CreateTilemap( const char* spriteName, int columns, int rows )
+	{
+		return PlayGraphics::Instance().CreateTilemap( PlayGraphics::Instance().GetSpriteId( spriteName ), columns, rows );
+	}
+
+	void DestroyTilemap( int tilemap )
+	{
+		PlayGraphics::Instance().DestroyTilemap( tilemap );
+	}
+
+	void SetTile( int tilemap, int column, int row, int tile )
+	{
+		PlayGraphics::Instance().SetTile( tilemap, column, row, tile );
+	}
+
+	int GetTile( int tilemap, int column, int row )
+	{
+		return PlayGraphics::Instance().GetTile( tilemap, column, row );
+	}
+
+	void DrawTilemap( int tilemap, Point2D pos )
+	{
+		PlayGraphics::Instance().DrawTilemap( tilemap, TRANSFORM_SPACE( pos ) );
+	}
+
+	int CreateRenderLayer( int width, int height )
+	{
+		return PlayGraphics::Instance().CreateRenderLayer( width, height );
+	}
+
+	void DestroyRenderLayer( int layer )
+	{
+		PlayGraphics::Instance().DestroyRenderLayer( layer );
+	}
+
+	void SetRenderLayerDirty( int layer )
+	{
+		PlayGraphics::Instance().SetRenderLayerDirty( layer );
+	}
+
+	bool IsRenderLayerDirty( int layer )
+	{
+		return PlayGraphics::Instance().IsRenderLayerDirty( layer );
+	}
+
+	// The drawing space to go back to after drawing into a render layer (which is always in screen space)
+	static DrawingSpace layerDrawSpace = WORLD;
+
+	void BeginRenderLayer( int layer )
+	{
+		PlayGraphics::Instance().BeginRenderLayer( layer );
+		layerDrawSpace = drawSpace;
+		drawSpace = SCREEN;
+	}
+
+	void EndRenderLayer( void )
 	{
-		PlayAudio::Destroy();
-		PlayGraphics::Destroy();
-		PlayWindow::Destroy();
-		PlayInput::Destroy();
-#ifdef PLAY_USING_GAMEOBJECT_MANAGER
-		for( std::pair<const int, GameObject&>& p : objectMap )
-			delete& p.second;
-		objectMap.clear();
-#endif
+		PlayGraphics::Instance().EndRenderLayer();
+		drawSpace = layerDrawSpace;
 	}
 
-	int GetBufferWidth()
+	void DrawRenderLayer( int layer, Point2D pos, float opacity )
 	{
-		return PlayWindow::Instance().GetWidth();
+		PlayGraphics::Instance().DrawRenderLayer( layer, TRANSFORM_SPACE( pos ), opacity );
 	}
 
-	int GetBufferHeight()
+	int OpenStreamingLevel( const char* levelPath, const char* tileSprite, int columns, int rows, int chunkSize )
 	{
-		return PlayWindow::Instance().GetHeight();
+		return PlayStreamer::Instance().OpenLevel( levelPath, PlayGraphics::Instance().GetSpriteId( tileSprite ), columns, rows, chunkSize );
 	}
 
-	//**************************************************************************************************
-	// PlayGraphics functions
-	//**************************************************************************************************
+	void CloseStreamingLevel( void )
+	{
+		PlayStreamer::Instance().CloseLevel();
+	}
 
-	void ClearDrawingBuffer( Colour c )
+	void UpdateStreamingLevel( void )
 	{
-		int r = static_cast<int>( c.red * 2.55f );
-		int g = static_cast<int>( c.green * 2.55f );
-		int b = static_cast<int>( c.blue * 2.55f );
-		PlayGraphics::Instance().ClearBuffer( { r, g, b } );
+		PixelData* pBuffer = PlayGraphics::Instance().GetDrawingBuffer();
+		PlayStreamer::Instance().Update( { cameraPos.x + ( pBuffer->width / 2.0f ), cameraPos.y + ( pBuffer->height / 2.0f ) } );
 	}
 
-	int LoadBackground( const char* pngFilename )
+	void SetStreamingRadius( float loadRadius, float unloadRadius )
 	{
-		return PlayGraphics::Instance().LoadBackground( pngFilename );
+		PlayStreamer::Instance().SetRadius( loadRadius, unloadRadius );
 	}
 
-	void DrawBackground( int background )
+	void SetStreamingBudget( int chunksPerFrame )
 	{
-		PlayGraphics::Instance().DrawBackground( background );
+		PlayStreamer::Instance().SetBudget( chunksPerFrame );
+	}
+
+	void DrawBackgroundLayers( void )
+	{
+		// Layers always scroll with the camera, but SCREEN drawing space pins them all in place
+		PlayGraphics::Instance().DrawBackgroundLayers( drawSpace == WORLD ? cameraPos : Point2f{ 0.0f, 0.0f } );
 	}
 
 	void DrawDebugText( Point2D pos, const char* text, Colour c, bool centred )
@@ -4099,12 +8216,31 @@ namespace Play
 		PlayGraphics::Instance().DrawDebugString( TRANSFORM_SPACE( pos ), text, { c.red * 2.55f, c.green * 2.55f, c.blue * 2.55f }, centred );
 	}
 
+	// Not exposed externally
+	// > Moves on to the next frame, whether or not anything was presented
+	void EndFrame()
+	{
+		frameCount++;
+
+		// Every frame is one tick of the simulation unless it's running on its own timestep
+		if( fixedTimestep <= 0.0f )
+			simulationTick++;
+
+#ifdef PLAY_USING_GAMEOBJECT_MANAGER
+		// The end of the frame is when the objects queued with DestroyGameObjectDeferred are actually destroyed
+		objectPool.FlushDeferred();
+#endif
+	}
+
 	void PresentDrawingBuffer()
 	{
 		PlayGraphics& pblt = PlayGraphics::Instance();
 		static bool debugInfo = false;
 		DrawingSpace originalDrawSpace = drawSpace;
 
+		// Anything other threads drew which hasn't been merged yet
+		pblt.FlushThreadDrawing();
+
 		if( KeyPressed( VK_F1 ) )
 			debugInfo = !debugInfo;
 
@@ -4121,13 +8257,34 @@ namespace Play
 			pblt.DrawDebugString( { textX - 1, textY + 1 }, s, PIX_BLACK, false );
 			pblt.DrawDebugString( { textX, textY }, s, PIX_YELLOW, false );
 
+			// The timings are from the last frame which was presented
+			textY += 20;
+			s = "Render:" + std::to_string( static_cast<int>( pblt.GetRenderTime() ) ) + "ms Latency:" + std::to_string( static_cast<int>( pblt.GetPresentLatency() ) ) + "ms";
+			pblt.DrawDebugString( { textX, textY }, s, PIX_YELLOW, false );
+
+			if( pblt.GetThreadedPresent() )
+			{
+				textY += 20;
+				s = "Present:" + std::to_string( static_cast<int>( pblt.GetPresenterTime() ) ) + "ms Dropped:" + std::to_string( pblt.GetFramesDropped() ) + "/" + std::to_string( pblt.GetFramesPresented() + pblt.GetFramesDropped() );
+				pblt.DrawDebugString( { textX, textY }, s, PIX_YELLOW, false );
+			}
+
+			PlayWindow& window = PlayWindow::Instance();
+			textY += 20;
+			s = "Frame:" + std::to_string( static_cast<int>( window.GetFrameTimeAverage() * 1000.0f ) ) + "us Jitter:" + std::to_string( static_cast<int>( window.GetFrameTimeJitter() * 1000.0f ) ) + "us Worst:" + std::to_string( static_cast<int>( window.GetFrameTimeWorstError() * 1000.0f ) ) + "us";
+			pblt.DrawDebugString( { textX, textY }, s, PIX_YELLOW, false );
+
+			textY += 20;
+			s = "Scale:" + std::to_string( static_cast<int>( pblt.GetRenderScale() * 100.0f ) ) + "% Upscale:" + std::to_string( static_cast<int>( pblt.GetUpscaleTime() * 1000.0f ) ) + "us";
+			pblt.DrawDebugString( { textX, textY }, s, PIX_YELLOW, false );
+
 			drawSpace = WORLD;
 
 #ifdef PLAY_USING_GAMEOBJECT_MANAGER
 			
-			for( std::pair<const int, GameObject&>& i : objectMap )
+			for( int i = 0; i < objectPool.Count(); i++ )
 			{
-				GameObject& obj = i.second;
+				GameObject& obj = objectPool.GetByIndex( i );
 				int id = obj.spriteId;
 				Vector2D size = pblt.GetSpriteSize( obj.spriteId );
 				Vector2D origin = pblt.GetSpriteOrigin( id );
@@ -4154,12 +8311,81 @@ namespace Play
 #endif
 		}
 
-		PlayWindow::Instance().Present();
-		frameCount++;
+		// The new frame repaints the whole window
+		PlayWindow::Instance().TakeRepaintRequest();
+		PlayGraphics::Instance().SubmitFrame( []( const PixelData& displayBuffer ) { PlayWindow::Instance().Present( displayBuffer ); } );
+
+		// The frame time is the slower of the last update and the render thread's drawing (which is zero without pipelined rendering)
+		pblt.UpdateDynamicResolution( std::max( PlayWindow::Instance().GetUpdateTime(), pblt.GetRenderTime() ) );
+		EndFrame();
 
 		drawSpace = originalDrawSpace;
 	}
 
+	void MarkFrameUnchanged()
+	{
+		PlayWindow& window = PlayWindow::Instance();
+
+		// Nothing new is presented, so a window which has been uncovered or moved needs the last frame again
+		if( window.TakeRepaintRequest() )
+			PlayGraphics::Instance().PresentLastFrame();
+
+		window.MarkFrameUnchanged();
+		EndFrame();
+	}
+
+	void SetDrawLayer( int layer )
+	{
+		PlayGraphics::Instance().SetDrawLayer( layer );
+	}
+
+	void SetPipelinedRendering( bool enable )
+	{
+		PlayGraphics::Instance().SetPipelinedRendering( enable );
+	}
+
+	float GetPresentLatency()
+	{
+		return PlayGraphics::Instance().GetPresentLatency();
+	}
+
+	void SetThreadedPresent( bool enable )
+	{
+		PlayGraphics::Instance().SetThreadedPresent( enable );
+		PlayWindow::Instance().SetPresentWaits( enable );
+	}
+
+	void SetTargetFrameRate( int framesPerSecond )
+	{
+		PlayWindow::Instance().SetTargetFrameRate( framesPerSecond );
+
+		// The dynamic resolution budget is one frame at the target frame rate
+		if( PlayGraphics::Instance().GetDynamicResolution() )
+			SetDynamicResolution( true );
+	}
+
+	void SetRenderScale( float scale )
+	{
+		PlayGraphics::Instance().SetRenderScale( scale );
+	}
+
+	float GetRenderScale()
+	{
+		return PlayGraphics::Instance().GetRenderScale();
+	}
+
+	void SetDynamicResolution( bool enable )
+	{
+		// The budget is one frame at the target frame rate (or the default frame rate if it isn't limited)
+		int framesPerSecond = PlayWindow::Instance().GetTargetFrameRate();
+		PlayGraphics::Instance().SetDynamicResolution( enable, 1000.0f / ( framesPerSecond > 0 ? framesPerSecond : FRAMES_PER_SECOND ) );
+	}
+
+	void SetSmoothUpscaling( bool smooth )
+	{
+		PlayGraphics::Instance().SetSmoothUpscaling( smooth );
+	}
+
 	Point2D GetMousePos()
 	{
 		PlayInput& input = PlayInput::Instance();
@@ -4203,6 +8429,54 @@ namespace Play
 
 	DrawingSpace GetDrawingSpace( void ) { return drawSpace; }
 
+	//**************************************************************************************************
+	// Fixed timestep functions
+	//**************************************************************************************************
+
+	// Drop the time which can't be caught up with in this many ticks, so a slow frame can't cause slower and slower frames
+	constexpr int MAX_TICKS_PER_FRAME = 8;
+
+	void SetFixedTimestep( int ticksPerSecond )
+	{
+		PLAY_ASSERT_MSG( ticksPerSecond >= 0, "Fixed timestep needs a positive number of ticks per second (or 0 to turn it off)" );
+		fixedTimestep = ticksPerSecond > 0 ? 1.0f / ticksPerSecond : 0.0f;
+		fixedAccumulator = 0.0f;
+	}
+
+	bool FixedUpdateStep( float elapsedTime )
+	{
+		bool firstCall = fixedFrame != frameCount;
+		fixedFrame = frameCount;
+
+		if( fixedTimestep <= 0.0f )
+			return firstCall;
+
+		if( firstCall )
+			fixedAccumulator = std::min( fixedAccumulator + elapsedTime, fixedTimestep * MAX_TICKS_PER_FRAME );
+
+		if( fixedAccumulator < fixedTimestep )
+			return false;
+
+		fixedAccumulator -= fixedTimestep;
+		simulationTick++;
+		return true;
+	}
+
+	float GetSimulationTimestep()
+	{
+		if( fixedTimestep > 0.0f )
+			return fixedTimestep;
+
+		// Without a frame rate to aim for, the last frame is the best guess at how long this one will be
+		PlayWindow& window = PlayWindow::Instance();
+		return window.GetTargetFrameRate() > 0 ? 1.0f / window.GetTargetFrameRate() : window.GetFrameTime() / 1000.0f;
+	}
+
+	float GetInterpolationAlpha()
+	{
+		return fixedTimestep > 0.0f ? fixedAccumulator / fixedTimestep : 1.0f;
+	}
+
 	//**************************************************************************************************
 	// PlayGraphics functions
 	//**************************************************************************************************
@@ -4329,29 +8603,29 @@ namespace Play
 		PlayGraphics::Instance().Draw( spriteID, TRANSFORM_SPACE( pos ), frameIndex );
 	}
 
-	void DrawSpriteTransparent( const char* spriteName, Point2D pos, int frameIndex, float opacity )
+	void DrawSpriteTransparent( const char* spriteName, Point2D pos, int frameIndex, float opacity, Colour tint )
 	{
-		PlayGraphics::Instance().DrawTransparent( PlayGraphics::Instance().GetSpriteId( spriteName ), TRANSFORM_SPACE( pos ), frameIndex, opacity );
+		PlayGraphics::Instance().DrawTransparent( PlayGraphics::Instance().GetSpriteId( spriteName ), TRANSFORM_SPACE( pos ), frameIndex, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawSpriteTransparent( int spriteID, Point2D pos, int frameIndex, float opacity )
+	void DrawSpriteTransparent( int spriteID, Point2D pos, int frameIndex, float opacity, Colour tint )
 	{
-		PlayGraphics::Instance().DrawTransparent( spriteID, TRANSFORM_SPACE( pos ), frameIndex, opacity );
+		PlayGraphics::Instance().DrawTransparent( spriteID, TRANSFORM_SPACE( pos ), frameIndex, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawSpriteRotated( const char* spriteName, Point2D pos, int frameIndex, float angle, float scale, float opacity )
+	void DrawSpriteRotated( const char* spriteName, Point2D pos, int frameIndex, float angle, float scale, float opacity, Colour tint )
 	{
-		PlayGraphics::Instance().DrawRotated( PlayGraphics::Instance().GetSpriteId( spriteName ), TRANSFORM_SPACE( pos ), frameIndex, angle, scale, opacity );
+		PlayGraphics::Instance().DrawRotated( PlayGraphics::Instance().GetSpriteId( spriteName ), TRANSFORM_SPACE( pos ), frameIndex, angle, scale, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawSpriteRotated( int spriteID, Point2D pos, int frameIndex, float angle, float scale, float opacity )
+	void DrawSpriteRotated( int spriteID, Point2D pos, int frameIndex, float angle, float scale, float opacity, Colour tint )
 	{
-		PlayGraphics::Instance().DrawRotated( spriteID, TRANSFORM_SPACE( pos ), frameIndex, angle, scale, opacity );
+		PlayGraphics::Instance().DrawRotated( spriteID, TRANSFORM_SPACE( pos ), frameIndex, angle, scale, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawSpriteTransformed( int spriteID, const Matrix2D& transform, int frameIndex, float opacity  )
+	void DrawSpriteTransformed( int spriteID, const Matrix2D& transform, int frameIndex, float opacity, Colour tint )
 	{
-		PlayGraphics::Instance().DrawTransformed( spriteID, TRANSFORM_MATRIX_SPACE( transform ), frameIndex, opacity );
+		PlayGraphics::Instance().DrawTransformed( spriteID, TRANSFORM_MATRIX_SPACE( transform ), frameIndex, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
 	void DrawLine( Point2f start, Point2f end, Colour c )
@@ -4372,7 +8646,6 @@ namespace Play
 	void DrawSpriteLine( Point2f startPos, Point2f endPos, const char* penSprite, Colour c )
 	{
 		int spriteId = PlayGraphics::Instance().GetSpriteId( penSprite );
-		ColourSprite( penSprite, c );
 
 		//Draws a line in any angle
 		int x1 = static_cast<int>( startPos.x );
@@ -4395,7 +8668,7 @@ namespace Play
 
 		while( true )
 		{
-			Play::DrawSprite( spriteId, { x1, y1 }, 0 );
+			Play::DrawSpriteTransparent( spriteId, { x1, y1 }, 0, 1.0f, c );
 			
 			if( x1 == x2 && y1 == y2 )
 				break;
@@ -4415,29 +8688,28 @@ namespace Play
 	}
 
 	// Not exposed externally
-	void DrawCircleOctants( int spriteId, int x, int y, int ox, int oy )
+	void DrawCircleOctants( int spriteId, int x, int y, int ox, int oy, Colour c )
 	{
 		//displaying all 8 coordinates of(x,y) residing in 8-octants
-		Play::DrawSprite( spriteId, { x + ox, y + oy }, 0 );
-		Play::DrawSprite( spriteId, { x - ox, y + oy }, 0 );
-		Play::DrawSprite( spriteId, { x + ox, y - oy }, 0 );
-		Play::DrawSprite( spriteId, { x - ox, y - oy }, 0 );
-		Play::DrawSprite( spriteId, { x + oy, y + ox }, 0 );
-		Play::DrawSprite( spriteId, { x - oy, y + ox }, 0 );
-		Play::DrawSprite( spriteId, { x + oy, y - ox }, 0 );
-		Play::DrawSprite( spriteId, { x - oy, y - ox }, 0 );
+		Play::DrawSpriteTransparent( spriteId, { x + ox, y + oy }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x - ox, y + oy }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x + ox, y - oy }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x - ox, y - oy }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x + oy, y + ox }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x - oy, y + ox }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x + oy, y - ox }, 0, 1.0f, c );
+		Play::DrawSpriteTransparent( spriteId, { x - oy, y - ox }, 0, 1.0f, c );
 	}
 
 	void DrawSpriteCircle( Point2D pos, int radius, const char* penSprite, Colour c )
 	{
 		int spriteId = PlayGraphics::Instance().GetSpriteId( penSprite );
-		ColourSprite( penSprite, c );
 
 		pos = TRANSFORM_SPACE( pos );
 
 		int ox = 0, oy = radius;
 		int d = 3 - 2 * radius;
-		DrawCircleOctants( spriteId, static_cast<int>(pos.x), static_cast<int>(pos.y), ox, oy );
+		DrawCircleOctants( spriteId, static_cast<int>(pos.x), static_cast<int>(pos.y), ox, oy, c );
 
 		while( oy >= ox )
 		{
@@ -4449,243 +8721,709 @@ namespace Play
 			}
 			else
 			{
-				d = d + 4 * ox + 6;
+				d = d + 4 * ox + 6;
+			}
+			DrawCircleOctants( spriteId, static_cast<int>(pos.x), static_cast<int>(pos.y), ox, oy, c );
+		}
+	};
+
+	int GetFontTextWidth( const char* fontId, std::string text )
+	{
+		int font = PlayGraphics::Instance().GetSpriteId( fontId );
+
+		int totalWidth{ 0 };
+
+		for( char c : text )
+			totalWidth += PlayGraphics::Instance().GetFontCharWidth( font, c );
+
+		return totalWidth;
+	}
+
+	void DrawFontText( const char* fontId, std::string text, Point2D pos, Align justify )
+	{
+		int font = PlayGraphics::Instance().GetSpriteId( fontId );
+		int totalWidth = GetFontTextWidth( fontId, text );
+
+		switch( justify )
+		{
+			case CENTRE:
+				pos.x -= totalWidth / 2;
+				break;
+			case RIGHT:
+				pos.x -= totalWidth;
+				break;
+			default:
+				break;
+		}
+
+		pos.x += PlayGraphics::Instance().GetSpriteOrigin( font ).x;
+		PlayGraphics::Instance().DrawString( font, TRANSFORM_SPACE( pos ), text );
+	}
+
+	void BeginTimingBar( Colour c )
+	{
+		PlayGraphics::Instance().TimingBarBegin( Pixel( c.red*2.55f, c.green*2.55f, c.blue*2.55f ) );
+	}
+
+	int ColourTimingBar( Colour c )
+	{
+		return PlayGraphics::Instance().SetTimingBarColour( Pixel( c.red * 2.55f, c.green * 2.55f, c.blue * 2.55f ) );
+	}
+
+	void DrawTimingBar( Point2f pos, Point2f size )
+	{
+		PlayGraphics::Instance().DrawTimingBar( pos, size );
+	}
+
+
+	//**************************************************************************************************
+	// GameObject functions
+	//**************************************************************************************************
+
+#ifdef PLAY_USING_GAMEOBJECT_MANAGER
+
+	// Set while ParallelUpdateGameObjects' function is running on several threads at once
+	static bool parallelUpdate = false;
+
+	int CreateGameObject( int type, Point2f newPos, int collisionRadius, const char* spriteName )
+	{
+		PLAY_ASSERT_MSG( !parallelUpdate, "Use the commands to create GameObjects inside ParallelUpdateGameObjects" );
+		int spriteId = PlayGraphics::Instance().GetSpriteId( spriteName );
+		// Deletion is handled in DestroyGameObject()
+		return objectPool.Create( type, newPos, collisionRadius, spriteId );
+	}
+
+	GameObject& GetGameObject( int ID )
+	{
+		GameObject* pObj = objectPool.Find( ID );
+
+		if( !pObj )
+			return noObject;
+
+		// The caller might move the object, so the spatial hash needs to check it on the next update
+		// > Other threads can look at objects during ParallelUpdateGameObjects, but only change their own
+		if( !parallelUpdate )
+			objectPool.Touch( *pObj );
+		return *pObj;
+	}
+
+	GameObject& GetGameObjectByType( int type )
+	{
+		int count = objectPool.CountOfType( type );
+		PLAY_ASSERT_MSG( count <= 1, "Multiple objects of type found, use CollectGameObjectIDsByType instead" );
+
+		if( count == 0 )
+			return noObject;
+
+		GameObject& obj = objectPool.GetOfType( type, 0 );
+		objectPool.Touch( obj );
+		return obj;
+	}
+
+	std::vector<int> CollectGameObjectIDsByType( int type )
+	{
+		int count = objectPool.CountOfType( type );
+		std::vector<int> vec;
+		vec.reserve( count );
+
+		for( int i = 0; i < count; i++ )
+			vec.push_back( objectPool.GetOfType( type, i ).GetId() );
+
+		return vec; // Returning a copy of the vector
+	}
+
+	std::vector<int> CollectAllGameObjectIDs()
+	{
+		std::vector<int> vec;
+		vec.reserve( objectPool.Count() );
+
+		for( int i = 0; i < objectPool.Count(); i++ )
+			vec.push_back( objectPool.GetByIndex( i ).GetId() );
+
+		return vec; // Returning a copy of the vector
+	}
+
+	// Not exposed externally
+	void WrapGameObject( GameObject& obj, int wrapBorderSize, int dWidth, int dHeight )
+	{
+		Vector2f origin = PlayGraphics::Instance().GetSpriteOrigin( obj.spriteId );
+		Point2f wrapped = obj.pos;
+
+		if( obj.pos.x - origin.x - wrapBorderSize > dWidth )
+			wrapped.x = 0.0f - wrapBorderSize + origin.x;
+		else if( obj.pos.x + origin.x + wrapBorderSize < 0 )
+			wrapped.x = dWidth + wrapBorderSize - origin.x;
+
+		if( obj.pos.y - origin.y - wrapBorderSize > dHeight )
+			wrapped.y = 0.0f - wrapBorderSize + origin.y;
+		else if( obj.pos.y + origin.y + wrapBorderSize < 0 )
+			wrapped.y = dHeight + wrapBorderSize - origin.y;
+
+		// The old position moves with it so the object isn't drawn sweeping across the screen between the two
+		obj.oldPos += wrapped - obj.pos;
+		obj.pos = wrapped;
+	}
+
+	// Sleeping objects are woken within this distance of the screen (negative if turned off)
+	static float cameraWakeDistance = -1.0f;
+	static int cameraWakeFrame = -1;
+
+	int WakeGameObjectsNear( Point2f pos, int radius, unsigned int typeMask )
+	{
+		objectPool.UpdateGrid( frameCount );
+
+		int woken = 0;
+		objectPool.ForEachNearby( pos, radius, [&]( GameObject& obj )
+		{
+			if( !obj.asleep || obj.GetType() < 0 || obj.GetType() >= 32 || !( typeMask & ( 1u << obj.GetType() ) ) )
+				return;
+
+			Vector2f diff = obj.pos - pos;
+			float radii = static_cast<float>( radius + obj.radius );
+
+			if( diff.LengthSqr() < radii * radii )
+			{
+				obj.asleep = false;
+				woken++;
+			}
+		} );
+
+		return woken;
+	}
+
+	void SetCameraWakeDistance( float distance )
+	{
+		cameraWakeDistance = distance;
+	}
+
+	// Not exposed externally
+	// > Wakes all the sleeping objects near the screen in one go (at most once per frame)
+	void WakeGameObjectsNearCamera()
+	{
+		if( cameraWakeDistance < 0.0f || cameraWakeFrame == frameCount )
+			return;
+
+		cameraWakeFrame = frameCount;
+
+		Vector2f halfSize = Vector2f( PlayWindow::Instance().GetWidth(), PlayWindow::Instance().GetHeight() ) / 2.0f;
+		Point2f centre = ( drawSpace == WORLD ? cameraPos : Point2f( 0.0f, 0.0f ) ) + halfSize;
+
+		// Search a circle around the screen, then check each object against the screen's rectangle
+		objectPool.UpdateGrid( frameCount );
+		objectPool.ForEachNearby( centre, static_cast<int>( halfSize.Length() + cameraWakeDistance ) + 1, [&]( GameObject& obj )
+		{
+			float reach = cameraWakeDistance + obj.radius;
+
+			if( obj.asleep && std::abs( obj.pos.x - centre.x ) < halfSize.x + reach && std::abs( obj.pos.y - centre.y ) < halfSize.y + reach )
+				obj.asleep = false;
+		} );
+	}
+
+	// Not exposed externally
+	// > Returns false if the object's update policy means it shouldn't move this frame
+	bool IsGameObjectDueUpdate( GameObject& obj )
+	{
+		if( obj.asleep )
+			return false;
+
+		// Objects with the same interval are spread out over the frames by their ids
+		// > Unsigned, as adding a large id to the tick could overflow an int
+		return obj.updateInterval <= 1 || ( static_cast<uint32_t>( simulationTick ) + static_cast<uint32_t>( obj.GetId() ) ) % static_cast<uint32_t>( obj.updateInterval ) == 0;
+	}
+
+	void UpdateGameObject( GameObject& obj, bool bWrap, int wrapBorderSize, bool allowMultipleUpdatesPerFrame )
+	{
+		if( obj.GetType() == -1 ) return; // Don't update noObject
+
+		// ParallelUpdateGameObjects does these for all its objects, as they change data shared between the objects
+		if( !parallelUpdate )
+		{
+			objectPool.Touch( obj );
+			WakeGameObjectsNearCamera();
+		}
+
+		// We allow multiple updates if the object type has changed
+		PLAY_ASSERT_MSG( obj.lastFrameUpdated != simulationTick || obj.GetType() != obj.oldType || allowMultipleUpdatesPerFrame, "Trying to update the same GameObject more than once in the same frame!" );
+		obj.lastFrameUpdated = simulationTick;
+
+		// Save the current position in case we need to go back
+		obj.oldPos = obj.pos;
+		obj.oldRot = obj.rotation;
+
+		if( !IsGameObjectDueUpdate( obj ) )
+			return;
+
+		if( obj.updateInterval <= 1 )
+		{
+			// Move the object according to a very simple physical model
+			obj.velocity += obj.acceleration;
+			obj.pos += obj.velocity;
+			obj.rotation += obj.rotSpeed;
+
+			// Handle the animation frame update
+			obj.framePos += obj.animSpeed;
+			if( obj.framePos > 1.0f )
+			{
+				obj.frame++;
+				obj.framePos -= 1.0f;
+			}
+		}
+		else
+		{
+			// Make up for the frames which were skipped, ending up where the frame-by-frame updates would have
+			float steps = static_cast<float>( obj.updateInterval );
+			obj.velocity += obj.acceleration * steps;
+			obj.pos += obj.velocity * steps - obj.acceleration * ( steps * ( steps - 1.0f ) / 2.0f );
+			obj.rotation += obj.rotSpeed * steps;
+
+			obj.framePos += obj.animSpeed * steps;
+			while( obj.framePos > 1.0f )
+			{
+				obj.frame++;
+				obj.framePos -= 1.0f;
 			}
-			DrawCircleOctants( spriteId, static_cast<int>(pos.x), static_cast<int>(pos.y), ox, oy );
 		}
-	};
 
-	void DrawFontText( const char* fontId, std::string text, Point2D pos, Align justify )
-	{
-		int font = PlayGraphics::Instance().GetSpriteId( fontId );
+		// Wrap objects around the screen
+		if( bWrap )
+			WrapGameObject( obj, wrapBorderSize, PlayWindow::Instance().GetWidth(), PlayWindow::Instance().GetHeight() );
 
-		int totalWidth{ 0 };
+	}
 
-		for( char c : text )
-			totalWidth += PlayGraphics::Instance().GetFontCharWidth( font, c );
+	void DestroyGameObject( int ID )
+	{
+		PLAY_ASSERT_MSG( !parallelUpdate, "Use the commands to destroy GameObjects inside ParallelUpdateGameObjects" );
+		bool bDestroyed = objectPool.Destroy( ID );
+		PLAY_ASSERT_MSG( bDestroyed, "Unable to find object with given ID" );
+	}
 
-		switch( justify )
-		{
-			case CENTRE:
-				pos.x -= totalWidth / 2;
-				break;
-			case RIGHT:
-				pos.x -= totalWidth;
-				break;
-			default:
-				break;
-		}
+	void DestroyGameObjectsByType( int objType )
+	{
+		std::vector<int> typeVec = CollectGameObjectIDsByType( objType );
+		for( size_t i = 0; i < typeVec.size(); i++ )
+			DestroyGameObject( typeVec[i] );
+	}
 
-		pos.x += PlayGraphics::Instance().GetSpriteOrigin( font ).x;
-		PlayGraphics::Instance().DrawString( font, TRANSFORM_SPACE( pos ), text );
+	void DestroyAllGameObjects()
+	{
+		objectPool.Clear();
 	}
 
-	void BeginTimingBar( Colour c )
+	void SetGameObjectType( GameObject& obj, int type )
 	{
-		PlayGraphics::Instance().TimingBarBegin( Pixel( c.red*2.55f, c.green*2.55f, c.blue*2.55f ) );
+		PLAY_ASSERT_MSG( !parallelUpdate, "Use the commands to change GameObjects' types inside ParallelUpdateGameObjects" );
+		objectPool.SetType( obj, type );
 	}
 
-	int ColourTimingBar( Colour c )
+	void ForEachGameObject( int type, void ( *pFunction )( GameObject& obj, void* pData ), void* pData )
 	{
-		return PlayGraphics::Instance().SetTimingBarColour( Pixel( c.red * 2.55f, c.green * 2.55f, c.blue * 2.55f ) );
+		objectPool.ForEachOfType( type, pFunction, pData );
 	}
 
-	void DrawTimingBar( Point2f pos, Point2f size )
+	void DestroyGameObjectDeferred( int ID )
 	{
-		PlayGraphics::Instance().DrawTimingBar( pos, size );
+		PLAY_ASSERT_MSG( !parallelUpdate, "Use the commands to destroy GameObjects inside ParallelUpdateGameObjects" );
+		PLAY_ASSERT_MSG( objectPool.Find( ID ), "Unable to find object with given ID" );
+		objectPool.DestroyDeferred( ID );
 	}
 
+	void FlushDestroyedGameObjects()
+	{
+		objectPool.FlushDeferred();
+	}
 
-	//**************************************************************************************************
-	// GameObject functions
-	//**************************************************************************************************
+	bool IsColliding( GameObject& object1, GameObject& object2 )
+	{
+		//Don't collide with noObject
+		if( object1.GetType() == -1 || object2.GetType() == -1 )
+			return false;
 
-#ifdef PLAY_USING_GAMEOBJECT_MANAGER
+		int xDiff = int( object1.pos.x ) - int( object2.pos.x );
+		int yDiff = int( object1.pos.y ) - int( object2.pos.y );
+		int radii = object2.radius + object1.radius;
 
-	int CreateGameObject( int type, Point2f newPos, int collisionRadius, const char* spriteName )
-	{
-		int spriteId = PlayGraphics::Instance().GetSpriteId( spriteName );
-		// Deletion is handled in DestroyGameObject()
-		GameObject* pObj = new GameObject( type, newPos, collisionRadius, spriteId );
-		int id = pObj->GetId();
-		objectMap.insert( std::map<int, GameObject&>::value_type( id, *pObj ) );
-		return id;
+		// Game progammers don't do square root!
+		return( ( xDiff * xDiff ) + ( yDiff * yDiff ) < radii * radii );
 	}
 
-	GameObject& GetGameObject( int ID )
+	// The nearby objects found by the grid, packed into arrays so CollideCircles can test several at once
+	struct CircleCandidates
 	{
-		std::map<int, GameObject&>::iterator i = objectMap.find( ID );
+		std::vector<float> posX, posY, radius;
+		std::vector<GameObject*> vObjects;
+		std::vector<uint32_t> vHitMasks;
+	};
 
-		if( i == objectMap.end() )
-			return noObject;
+	// Reused every time so the arrays only allocate when the number of candidates grows
+	// > One for each thread, as ParallelUpdateGameObjects' functions can test collisions at the same time
+	thread_local CircleCandidates candidates;
 
-		return i->second;
+	// Not exposed externally
+	// > Calls onHit for every object near the circle which is accepted by the filter and overlaps the circle
+	template< typename Filter, typename Function >
+	void ForEachOverlappingObject( Point2f pos, int radius, Filter filter, Function onHit )
+	{
+		candidates.posX.clear();
+		candidates.posY.clear();
+		candidates.radius.clear();
+		candidates.vObjects.clear();
+
+		objectPool.ForEachNearby( pos, radius, [&]( GameObject& obj )
+		{
+			if( !filter( obj ) )
+				return;
+
+			candidates.posX.push_back( obj.pos.x );
+			candidates.posY.push_back( obj.pos.y );
+			candidates.radius.push_back( static_cast<float>( obj.radius ) );
+			candidates.vObjects.push_back( &obj );
+		} );
+
+		int count = static_cast<int>( candidates.vObjects.size() );
+		candidates.vHitMasks.resize( ( count + 31 ) / 32 );
+		CollideCircles( pos, static_cast<float>( radius ), candidates.posX.data(), candidates.posY.data(), candidates.radius.data(), count, candidates.vHitMasks.data() );
+
+		for( int word = 0; word < static_cast<int>( candidates.vHitMasks.size() ); word++ )
+		{
+			for( uint32_t hits = candidates.vHitMasks[word], bit = 0; hits != 0; hits >>= 1, bit++ )
+			{
+				if( hits & 1 )
+					onHit( *candidates.vObjects[word * 32 + bit] );
+			}
+		}
 	}
 
-	GameObject& GetGameObjectByType( int type )
+	bool IsCollidingPixel( GameObject& object1, GameObject& object2 )
 	{
-		int count = 0;
-
-		for( std::pair<const int, GameObject&>& i : objectMap )
-			if( i.second.type == type ) { count++; }
+		//Don't collide with noObject or objects without sprites
+		if( object1.GetType() == -1 || object2.GetType() == -1 || object1.spriteId == -1 || object2.spriteId == -1 )
+			return false;
 
-		PLAY_ASSERT_MSG( count <= 1, "Multiple objects of type found, use CollectGameObjectIDsByType instead" );
+		PlayGraphics& pblt = PlayGraphics::Instance();
 
-		for( std::pair<const int, GameObject&>& i : objectMap )
+		// Quickly rule out sprites which are too far apart to touch, whatever their rotation
+		float reach = 0.0f;
+		for( GameObject* pObj : { &object1, &object2 } )
 		{
-			if( i.second.type == type )
-				return i.second;
+			Vector2f size = pblt.GetSpriteSize( pObj->spriteId );
+			Vector2f origin = pblt.GetSpriteOrigin( pObj->spriteId );
+			Vector2f farCorner = { std::max( origin.x, size.width - origin.x ), std::max( origin.y, size.height - origin.y ) };
+			reach += farCorner.Length();
 		}
 
-		return noObject;
+		Vector2f diff = object2.pos - object1.pos;
+		if( diff.LengthSqr() >= reach * reach )
+			return false;
+
+		return pblt.MaskCollide( object1.spriteId, object1.pos, object1.frame, object1.rotation, object2.spriteId, object2.pos, object2.frame, object2.rotation );
 	}
 
-	std::vector<int> CollectGameObjectIDsByType( int type )
+	std::vector<int> QueryCircle( Point2f pos, int radius, unsigned int typeMask )
 	{
+		objectPool.UpdateGrid( frameCount );
+
 		std::vector<int> vec;
-		for( std::pair<const int, GameObject&>& i : objectMap )
-		{
-			if( i.second.type == type )
-				vec.push_back( i.first );
-		}
+		ForEachOverlappingObject( pos, radius,
+			[&]( GameObject& obj ) { return obj.GetType() >= 0 && obj.GetType() < 32 && ( typeMask & ( 1u << obj.GetType() ) ); },
+			[&]( GameObject& obj ) { vec.push_back( obj.GetId() ); } );
+
 		return vec; // Returning a copy of the vector
 	}
 
-	std::vector<int> CollectAllGameObjectIDs()
+	std::vector< std::pair<int, int> > CollectCollidingPairs( int typeA, int typeB )
 	{
-		std::vector<int> vec;
+		objectPool.UpdateGrid( frameCount );
+		std::vector< std::pair<int, int> > vec;
+		int count = objectPool.CountOfType( typeA );
+
+		for( int i = 0; i < count; i++ )
+		{
+			GameObject& objA = objectPool.GetOfType( typeA, i );
 
-		for( std::pair<const int, GameObject&>& i : objectMap )
-			vec.push_back( i.first );
+			// When both types are the same each pair is only reported once
+			ForEachOverlappingObject( objA.pos, objA.radius,
+				[&]( GameObject& objB ) { return objB.GetType() == typeB && ( typeA != typeB || objB.GetId() > objA.GetId() ); },
+				[&]( GameObject& objB ) { vec.push_back( { objA.GetId(), objB.GetId() } ); } );
+		}
 
 		return vec; // Returning a copy of the vector
 	}
 
-	void UpdateGameObject( GameObject& obj, bool bWrap, int wrapBorderSize, bool allowMultipleUpdatesPerFrame )
+	void SetCollisionGridCellSize( int cellSize )
 	{
-		if( obj.type == -1 ) return; // Don't update noObject
-
-		// We allow multiple updates if the object type has changed
-		PLAY_ASSERT_MSG( obj.lastFrameUpdated != frameCount || obj.type != obj.oldType || allowMultipleUpdatesPerFrame, "Trying to update the same GameObject more than once in the same frame!" );
-		obj.lastFrameUpdated = frameCount;
+		objectPool.SetGridCellSize( cellSize );
+	}
 
-		// Save the current position in case we need to go back
-		obj.oldPos = obj.pos;
-		obj.oldRot = obj.rotation;
+	// The layers each collision layer collides with (bit n is set for layer n)
+	static unsigned int collisionMatrix[32] = {};
+	// The pairs found by the latest and previous calls to UpdateCollisions
+	static std::vector<CollisionPair> vCollisionPairs;
+	static std::vector<CollisionPair> vPreviousCollisionPairs;
 
-		// Move the object according to a very simple physical model
-		obj.velocity += obj.acceleration;
-		obj.pos += obj.velocity;
-		obj.rotation += obj.rotSpeed;
+	void SetLayerCollision( int layerA, int layerB, bool collide )
+	{
+		PLAY_ASSERT_MSG( layerA >= 0 && layerA < 32 && layerB >= 0 && layerB < 32, "Collision layers must be from 0 to 31" );
 
-		// Handle the animation frame update
-		obj.framePos += obj.animSpeed;
-		if( obj.framePos > 1.0f )
+		if( collide )
 		{
-			obj.frame++;
-			obj.framePos -= 1.0f;
+			collisionMatrix[layerA] |= 1u << layerB;
+			collisionMatrix[layerB] |= 1u << layerA;
 		}
-
-		// Wrap objects around the screen
-		if( bWrap )
+		else
 		{
-			int dWidth = PlayWindow::Instance().GetWidth();
-			int dHeight = PlayWindow::Instance().GetHeight();
-			Vector2f origin = PlayGraphics::Instance().GetSpriteOrigin( obj.spriteId );
-
-			if( obj.pos.x - origin.x - wrapBorderSize > dWidth )
-				obj.pos.x = 0.0f - wrapBorderSize + origin.x;
-			else if( obj.pos.x + origin.x + wrapBorderSize < 0 )
-				obj.pos.x = dWidth + wrapBorderSize - origin.x;
-
-			if( obj.pos.y - origin.y - wrapBorderSize > dHeight )
-				obj.pos.y = 0.0f - wrapBorderSize + origin.y;
-			else if( obj.pos.y + origin.y + wrapBorderSize < 0 )
-				obj.pos.y = dHeight + wrapBorderSize - origin.y;
+			collisionMatrix[layerA] &= ~( 1u << layerB );
+			collisionMatrix[layerB] &= ~( 1u << layerA );
 		}
+	}
 
+	// Not exposed externally
+	bool CollisionPairLess( const CollisionPair& pair1, const CollisionPair& pair2 )
+	{
+		return pair1.idA < pair2.idA || ( pair1.idA == pair2.idA && pair1.idB < pair2.idB );
 	}
 
-	void DestroyGameObject( int ID )
+	void UpdateCollisions()
 	{
-		if( objectMap.find( ID ) == objectMap.end() )
+		objectPool.UpdateGrid( frameCount );
+
+		// The new pairs go in a separate buffer so they can be compared with the previous ones
+		std::swap( vCollisionPairs, vPreviousCollisionPairs );
+		vCollisionPairs.clear();
+
+		for( int i = 0; i < objectPool.Count(); i++ )
 		{
-			PLAY_ASSERT_MSG( false, "Unable to find object with given ID" );
+			GameObject& objA = objectPool.GetByIndex( i );
+			int layerA = objA.collisionLayer;
+
+			if( layerA < 0 || layerA >= 32 )
+				continue;
+
+			unsigned int layersA = collisionMatrix[layerA] & objA.collisionMask;
+			if( layersA == 0 )
+				continue;
+
+			ForEachOverlappingObject( objA.pos, objA.radius, [&]( GameObject& objB )
+			{
+				int layerB = objB.collisionLayer;
+
+				if( layerB < 0 || layerB >= 32 || !( layersA & ( 1u << layerB ) ) || !( objB.collisionMask & ( 1u << layerA ) ) )
+					return false;
+
+				// Every pair is found from both of its objects, so it's only kept when objA is the one which comes first
+				return layerB > layerA || ( layerB == layerA && objB.GetId() > objA.GetId() );
+			},
+			[&]( GameObject& objB ) { vCollisionPairs.push_back( { objA.GetId(), objB.GetId(), COLLISION_ENTER } ); } );
 		}
-		else
+
+		std::sort( vCollisionPairs.begin(), vCollisionPairs.end(), CollisionPairLess );
+
+		// Both lists are sorted, so walking through them together finds the pairs which are staying and the ones which have exited
+		size_t count = vCollisionPairs.size();
+		size_t prev = 0;
+
+		for( size_t i = 0; i <= count; i++ )
 		{
-			GameObject* go = &objectMap.find( ID )->second;
-			delete go;
-			objectMap.erase( ID );
+			while( prev < vPreviousCollisionPairs.size() && ( i == count || CollisionPairLess( vPreviousCollisionPairs[prev], vCollisionPairs[i] ) ) )
+			{
+				// Pairs which had already exited are forgotten
+				if( vPreviousCollisionPairs[prev].state != COLLISION_EXIT )
+					vCollisionPairs.push_back( { vPreviousCollisionPairs[prev].idA, vPreviousCollisionPairs[prev].idB, COLLISION_EXIT } );
+				prev++;
+			}
+
+			if( i < count && prev < vPreviousCollisionPairs.size() && !CollisionPairLess( vCollisionPairs[i], vPreviousCollisionPairs[prev] ) )
+			{
+				if( vPreviousCollisionPairs[prev].state != COLLISION_EXIT )
+					vCollisionPairs[i].state = COLLISION_STAY;
+				prev++;
+			}
 		}
+
+		// The exits were added in order after the new pairs
+		std::inplace_merge( vCollisionPairs.begin(), vCollisionPairs.begin() + count, vCollisionPairs.end(), CollisionPairLess );
 	}
 
-	void DestroyGameObjectsByType( int objType )
+	const std::vector<CollisionPair>& GetCollisionPairs()
 	{
-		std::vector<int> typeVec = CollectGameObjectIDsByType( objType );
-		for( size_t i = 0; i < typeVec.size(); i++ )
-			DestroyGameObject( typeVec[i] );
+		return vCollisionPairs;
 	}
 
-	bool IsColliding( GameObject& object1, GameObject& object2 )
+	// The extents of each sprite relative to its origin, gathered once per culling pass
+	struct SpriteBounds
 	{
-		//Don't collide with noObject
-		if( object1.type == -1 || object2.type == -1 )
-			return false;
+		float left, top, right, bottom;
+		float radius; // Reaches the furthest corner from the origin, whatever the rotation
+	};
 
-		int xDiff = int( object1.pos.x ) - int( object2.pos.x );
-		int yDiff = int( object1.pos.y ) - int( object2.pos.y );
-		int radii = object2.radius + object1.radius;
+	// The result of the culling pass for a GameObject slot, which is only used while the object is unchanged
+	struct ObjectVisibility
+	{
+		int id{ -1 };
+		int pass{ -1 };
+		Point2f pos{ 0.0f, 0.0f };
+		int spriteId{ -1 };
+		float scale{ 1.0f };
+		bool visible{ false }; // The same result as the original IsVisible test
+		bool onScreen{ false }; // Whether any part of the sprite could be drawn (allowing for rotation, scaling and rounding)
+	};
 
-		// Game progammers don't do square root!
-		return( ( xDiff * xDiff ) + ( yDiff * yDiff ) < radii * radii );
-	}
+	static std::vector<SpriteBounds> vSpriteBounds;
+	static std::vector<ObjectVisibility> vObjectVisibility;
+	// The culling pass is repeated on a new frame or if the camera or drawing space changes
+	static int cullPass = -1;
+	static int cullFrame = -1;
+	static Point2f cullCamera{ 0.0f, 0.0f };
+	static DrawingSpace cullSpace = WORLD;
+	static float cullWidth = 0.0f;
+	static float cullHeight = 0.0f;
 
-	bool IsVisible( GameObject& obj )
+	// Not exposed externally
+	void GatherSpriteBounds()
 	{
-		if( obj.type == -1 ) return false; // Not for noObject
+		PLAY_ASSERT_MSG( !parallelUpdate, "Sprites can't be loaded inside ParallelUpdateGameObjects" );
 
 		PlayGraphics& pblt = PlayGraphics::Instance();
-		PlayWindow& pbuf = PlayWindow::Instance();
+		vSpriteBounds.resize( pblt.GetTotalLoadedSprites() );
 
-		int spriteID = obj.spriteId;
-		Vector2f spriteSize = pblt.GetSpriteSize( obj.spriteId );
-		Vector2f spriteOrigin = pblt.GetSpriteOrigin( spriteID );
+		for( int id = 0; id < static_cast<int>( vSpriteBounds.size() ); id++ )
+		{
+			Vector2f size = pblt.GetSpriteSize( id );
+			Vector2f origin = pblt.GetSpriteOrigin( id );
+			SpriteBounds& bounds = vSpriteBounds[id];
+			bounds.left = -origin.x;
+			bounds.top = -origin.y;
+			bounds.right = size.width - origin.x;
+			bounds.bottom = size.height - origin.y;
+			bounds.radius = Vector2f( std::max( -bounds.left, bounds.right ), std::max( -bounds.top, bounds.bottom ) ).Length();
+		}
+	}
+
+	// Not exposed externally
+	void CullGameObject( GameObject& obj, ObjectVisibility& vis )
+	{
+		vis.id = obj.GetId();
+		vis.pass = cullPass;
+		vis.pos = obj.pos;
+		vis.spriteId = obj.spriteId;
+		vis.scale = obj.scale;
+		vis.visible = vis.onScreen = false;
+
+		if( obj.spriteId < 0 )
+			return;
 
+		// Sprites added since the pass began won't have been gathered yet (which can't happen inside ParallelUpdateGameObjects)
+		if( obj.spriteId >= static_cast<int>( vSpriteBounds.size() ) )
+			GatherSpriteBounds();
+
+		const SpriteBounds& bounds = vSpriteBounds[obj.spriteId];
 		Point2f pos = TRANSFORM_SPACE( obj.pos );
 
-		return( pos.x + spriteSize.width - spriteOrigin.x > 0 && pos.x - spriteOrigin.x < pbuf.GetWidth() &&
-			pos.y + spriteSize.height - spriteOrigin.y > 0 && pos.y - spriteOrigin.y < pbuf.GetHeight() );
+		vis.visible = pos.x + bounds.right > 0 && pos.x + bounds.left < cullWidth && pos.y + bounds.bottom > 0 && pos.y + bounds.top < cullHeight;
+
+		// Drawing rounds to the nearest pixel, and DrawObjectRotated can rotate and scale the sprite
+		float reach = bounds.radius * std::max( obj.scale, 1.0f ) + 1.0f;
+		vis.onScreen = pos.x + reach > 0 && pos.x - reach < cullWidth && pos.y + reach > 0 && pos.y - reach < cullHeight;
 	}
 
-	bool IsLeavingDisplayArea( GameObject& obj, Direction dirn )
+	// Not exposed externally
+	// > Works out the visibility of all the GameObjects in one sweep
+	void CullGameObjects()
 	{
-		if( obj.type == -1 ) return false; // Not for noObject
+		cullPass++;
+		cullFrame = frameCount;
+		cullCamera = cameraPos;
+		cullSpace = drawSpace;
+		cullWidth = static_cast<float>( PlayWindow::Instance().GetWidth() );
+		cullHeight = static_cast<float>( PlayWindow::Instance().GetHeight() );
 
-		PlayWindow& pbuf = PlayWindow::Instance();
-		PlayGraphics& pblt = PlayGraphics::Instance();
+		GatherSpriteBounds();
+
+		for( int i = 0; i < objectPool.Count(); i++ )
+		{
+			GameObject& obj = objectPool.GetByIndex( i );
+			int index = objectPool.IndexOf( obj );
+
+			if( index >= static_cast<int>( vObjectVisibility.size() ) )
+				vObjectVisibility.resize( index + 1 );
 
-		int spriteID = obj.spriteId;
-		Vector2f spriteSize = pblt.GetSpriteSize( obj.spriteId );
-		Vector2f spriteOrigin = pblt.GetSpriteOrigin( spriteID );
+			CullGameObject( obj, vObjectVisibility[index] );
+		}
+	}
+
+	// Not exposed externally
+	// > Gets the object's visibility from the culling pass, checking it again if the object has changed since
+	// > Inside ParallelUpdateGameObjects the pass is already up to date, and objects which have changed are checked into a copy for each thread
+	const ObjectVisibility& GetObjectVisibility( GameObject& obj )
+	{
+		static ObjectVisibility notInPool;
+		thread_local ObjectVisibility threadVis;
+
+		if( cullFrame != frameCount || cullSpace != drawSpace || ( drawSpace == WORLD && ( cullCamera.x != cameraPos.x || cullCamera.y != cameraPos.y ) ) )
+		{
+			PLAY_ASSERT_MSG( !parallelUpdate, "The camera and drawing space can't be changed inside ParallelUpdateGameObjects" );
+			CullGameObjects();
+		}
+
+		int index = objectPool.IndexOf( obj );
+		if( index == -1 )
+			return notInPool;
+
+		if( index >= static_cast<int>( vObjectVisibility.size() ) )
+		{
+			if( parallelUpdate )
+			{
+				CullGameObject( obj, threadVis );
+				return threadVis;
+			}
+			vObjectVisibility.resize( index + 1 );
+		}
+
+		ObjectVisibility& vis = vObjectVisibility[index];
+
+		if( vis.pass != cullPass || vis.id != obj.GetId() || vis.pos.x != obj.pos.x || vis.pos.y != obj.pos.y || vis.spriteId != obj.spriteId || vis.scale != obj.scale )
+		{
+			if( parallelUpdate )
+			{
+				CullGameObject( obj, threadVis );
+				return threadVis;
+			}
+			CullGameObject( obj, vis );
+		}
+
+		return vis;
+	}
+
+	bool IsVisible( GameObject& obj )
+	{
+		if( obj.GetType() == -1 ) return false; // Not for noObject
+		return GetObjectVisibility( obj ).visible;
+	}
+
+	bool IsLeavingDisplayArea( GameObject& obj, Direction dirn )
+	{
+		if( obj.GetType() == -1 || obj.spriteId < 0 ) return false; // Not for noObject
+
+		// The culling pass gathers the sprite bounds and display size, so there's no need to look them up again
+		GetObjectVisibility( obj );
+		const SpriteBounds& bounds = vSpriteBounds[obj.spriteId];
 
 		Point2f pos = TRANSFORM_SPACE( obj.pos );
 
 		if( dirn != VERTICAL )
 		{
-			if( pos.x - spriteOrigin.x < 0 && obj.velocity.x < 0 )
+			if( pos.x + bounds.left < 0 && obj.velocity.x < 0 )
 				return true;
 
-			if( pos.x + spriteSize.width - spriteOrigin.x > pbuf.GetWidth() && obj.velocity.x > 0 )
+			if( pos.x + bounds.right > cullWidth && obj.velocity.x > 0 )
 				return true;
 		}
 
 		if( dirn != HORIZONTAL )
 		{
-			if( pos.y - spriteOrigin.y < 0 && obj.velocity.y < 0 )
+			if( pos.y + bounds.top < 0 && obj.velocity.y < 0 )
 				return true;
 
-			if( pos.y + spriteSize.height - spriteOrigin.y > pbuf.GetHeight() && obj.velocity.y > 0 )
+			if( pos.y + bounds.bottom > cullHeight && obj.velocity.y > 0 )
 				return true;
 		}
 
@@ -4694,13 +9432,13 @@ namespace Play
 
 	bool IsAnimationComplete( GameObject& obj )
 	{
-		if( obj.type == -1 ) return false; // Not for noObject
+		if( obj.GetType() == -1 ) return false; // Not for noObject
 		return obj.frame >= PlayGraphics::Instance().GetSpriteFrames( obj.spriteId ) - 1;
 	}
 
 	void SetGameObjectDirection( GameObject& obj, int speed, float angle )
 	{
-		if( obj.type == -1 ) return; // Not for noObject
+		if( obj.GetType() == -1 ) return; // Not for noObject
 
 		obj.velocity.x = speed * sin( angle );
 		obj.velocity.y = speed * -cos( angle );
@@ -4708,7 +9446,7 @@ namespace Play
 
 	void PointGameObject( GameObject& obj, int speed, int targetX, int targetY )
 	{
-		if( obj.type == -1 ) return; // Not for noObject
+		if( obj.GetType() == -1 ) return; // Not for noObject
 
 		float xdiff = obj.pos.x - targetX;
 		float ydiff = obj.pos.y - targetY;
@@ -4729,22 +9467,109 @@ namespace Play
 		obj.animSpeed = animSpeed;
 	}
 
+	// Not exposed externally
+	// > Returns how far to draw the object between its old and current position and rotation (1 is the current one)
+	float GetDrawAlpha( GameObject& obj )
+	{
+		// Only objects moved by the last tick have an old position which is one tick behind
+		if( fixedTimestep <= 0.0f || obj.lastFrameUpdated != simulationTick )
+			return 1.0f;
+
+		return GetInterpolationAlpha();
+	}
+
 	void DrawObject( GameObject& obj )
 	{
-		if( obj.type == -1 ) return; // Don't draw noObject
-		PlayGraphics::Instance().Draw( obj.spriteId, TRANSFORM_SPACE( obj.pos ), obj.frame );
+		if( obj.GetType() == -1 ) return; // Don't draw noObject
+		if( !GetObjectVisibility( obj ).onScreen ) return;
+		float alpha = GetDrawAlpha( obj );
+		Point2f pos = obj.oldPos + ( obj.pos - obj.oldPos ) * alpha;
+		PlayGraphics::Instance().Draw( obj.spriteId, TRANSFORM_SPACE( pos ), obj.frame );
+	}
+
+	void DrawObjectTransparent( GameObject& obj, float opacity, Colour tint )
+	{
+		if( obj.GetType() == -1 ) return; // Don't draw noObject
+		if( !GetObjectVisibility( obj ).onScreen ) return;
+		float alpha = GetDrawAlpha( obj );
+		Point2f pos = obj.oldPos + ( obj.pos - obj.oldPos ) * alpha;
+		PlayGraphics::Instance().DrawTransparent( obj.spriteId, TRANSFORM_SPACE( pos ), obj.frame, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawObjectTransparent( GameObject& obj, float opacity )
+	void DrawObjectRotated( GameObject& obj, float opacity, Colour tint )
 	{
-		if( obj.type == -1 ) return; // Don't draw noObject
-		PlayGraphics::Instance().DrawTransparent( obj.spriteId, TRANSFORM_SPACE( obj.pos ), obj.frame, opacity );
+		if( obj.GetType() == -1 ) return; // Don't draw noObject
+		if( !GetObjectVisibility( obj ).onScreen ) return;
+		float alpha = GetDrawAlpha( obj );
+		Point2f pos = obj.oldPos + ( obj.pos - obj.oldPos ) * alpha;
+		float rotation = obj.oldRot + ( obj.rotation - obj.oldRot ) * alpha;
+		PlayGraphics::Instance().DrawRotated( obj.spriteId, TRANSFORM_SPACE( pos ), obj.frame, rotation, obj.scale, opacity, { tint.red * 2.55f, tint.green * 2.55f, tint.blue * 2.55f } );
 	}
 
-	void DrawObjectRotated( GameObject& obj, float opacity )
+	// Objects are shared out between the threads in chunks of this many, each with its own commands
+	constexpr int PARALLEL_UPDATE_CHUNK = 64;
+
+	static std::vector<GameObject*> vParallelObjects;
+	// A deque so the commands never have to be moved
+	static std::deque<GameObjectCommands> parallelCommands;
+
+	void ParallelUpdateGameObjects( int type, void ( *pFunction )( GameObject& obj, GameObjectCommands& commands, void* pData ), void* pData )
 	{
-		if( obj.type == -1 ) return; // Don't draw noObject
-		PlayGraphics::Instance().DrawRotated( obj.spriteId, TRANSFORM_SPACE( obj.pos ), obj.frame, obj.rotation, obj.scale, opacity );
+		PLAY_ASSERT_MSG( !parallelUpdate, "ParallelUpdateGameObjects can't be called from inside ParallelUpdateGameObjects" );
+
+		int count = objectPool.CountOfType( type );
+
+		if( count == 0 )
+			return;
+
+		// Bring the shared data up to date first, so the threads only ever write to their own objects
+		WakeGameObjectsNearCamera();
+		GetObjectVisibility( noObject );
+
+		vParallelObjects.resize( count );
+		for( int t = 0; t < count; t++ )
+		{
+			GameObject& obj = objectPool.GetOfType( type, t );
+			vParallelObjects[t] = &obj;
+
+			int index = objectPool.IndexOf( obj );
+			if( index >= static_cast<int>( vObjectVisibility.size() ) )
+				vObjectVisibility.resize( index + 1 );
+		}
+
+		// The commands are kept per chunk rather than per thread, so they can be applied in the objects' order
+		int chunks = ( count + PARALLEL_UPDATE_CHUNK - 1 ) / PARALLEL_UPDATE_CHUNK;
+		while( static_cast<int>( parallelCommands.size() ) < chunks )
+			parallelCommands.emplace_back();
+
+		// Each chunk's drawing is recorded with the chunk as its key, so it's merged in the objects' order whichever thread did it
+		PlayGraphics& graphics = PlayGraphics::Instance();
+		int layer = PlayBlitter::GetThreadDrawLayer();
+
+		parallelUpdate = true;
+		PlayJobSystem::Instance().ParallelFor( chunks, [&]( int begin, int end )
+		{
+			for( int c = begin; c < end; c++ )
+			{
+				graphics.BeginThreadDrawing( c, layer );
+				int last = std::min( ( c + 1 ) * PARALLEL_UPDATE_CHUNK, count );
+				for( int t = c * PARALLEL_UPDATE_CHUNK; t < last; t++ )
+					pFunction( *vParallelObjects[t], parallelCommands[c], pData );
+				graphics.EndThreadDrawing();
+			}
+		}, 1 );
+		parallelUpdate = false;
+
+		// The layer may have been changed by the update function on this thread
+		PlayBlitter::SetThreadDrawLayer( layer );
+		graphics.FlushThreadDrawing();
+
+		// Catch up with what UpdateGameObject would have told the pool, then make the changes
+		for( int t = 0; t < count; t++ )
+			objectPool.Touch( *vParallelObjects[t] );
+
+		for( int c = 0; c < chunks; c++ )
+			parallelCommands[c].Apply();
 	}
 
 #endif
@@ -4778,6 +9603,93 @@ namespace Play
 			return end + rnd;
 	}
 }
+
+#ifdef PLAY_USING_GAMEOBJECT_MANAGER
+
+//**************************************************************************************************
+// GameObjectCommands Class Definition
+//**************************************************************************************************
+
+GameObjectCommands::~GameObjectCommands()
+{
+	for( GameObject* pObj : m_vCreated )
+		delete pObj;
+}
+
+GameObject& GameObjectCommands::CreateGameObject( int type, Point2D pos, int collisionRadius, const char* spriteName )
+{
+	if( m_createdCount == static_cast<int>( m_vCreated.size() ) )
+		m_vCreated.push_back( new GameObject );
+
+	// Set up like the pool does, but without giving out an id from another thread
+	GameObject& obj = *m_vCreated[m_createdCount];
+	obj = GameObject();
+	obj.m_type = type;
+	obj.pos = pos;
+	obj.radius = collisionRadius;
+	obj.spriteId = PlayGraphics::Instance().GetSpriteId( spriteName );
+
+	m_vCommands.push_back( { COMMAND_CREATE, m_createdCount++, 0, {} } );
+	return obj;
+}
+
+void GameObjectCommands::DestroyGameObject( int id )
+{
+	m_vCommands.push_back( { COMMAND_DESTROY, id, 0, {} } );
+}
+
+void GameObjectCommands::SetGameObjectType( GameObject& obj, int type )
+{
+	m_vCommands.push_back( { COMMAND_SET_TYPE, obj.GetId(), type, {} } );
+}
+
+void GameObjectCommands::PlayAudio( const char* mp3Filename )
+{
+	m_vCommands.push_back( { COMMAND_PLAY_AUDIO, -1, 0, mp3Filename } );
+}
+
+void GameObjectCommands::Apply()
+{
+	for( Command& c : m_vCommands )
+	{
+		switch( c.command )
+		{
+			case COMMAND_CREATE:
+			{
+				GameObject& staged = *m_vCreated[c.id];
+				GameObject& obj = Play::GetGameObject( Play::objectPool.Create( staged.m_type, staged.pos, staged.radius, staged.spriteId ) );
+				// Keep the update history the pool started, like Play::CreateGameObject, whatever was done to the staged copy
+				int id = obj.m_id;
+				int oldType = obj.oldType;
+				Point2f oldPos = obj.oldPos;
+				float oldRot = obj.oldRot;
+				int lastFrameUpdated = obj.lastFrameUpdated;
+				obj = staged;
+				obj.m_id = id;
+				obj.oldType = oldType;
+				obj.oldPos = oldPos;
+				obj.oldRot = oldRot;
+				obj.lastFrameUpdated = lastFrameUpdated;
+				break;
+			}
+			case COMMAND_DESTROY:
+				Play::DestroyGameObject( c.id );
+				break;
+			case COMMAND_SET_TYPE:
+				Play::SetGameObjectType( Play::GetGameObject( c.id ), c.type );
+				break;
+			case COMMAND_PLAY_AUDIO:
+				Play::PlayAudio( c.audio.c_str() );
+				break;
+		}
+	}
+
+	m_vCommands.clear();
+	m_createdCount = 0;
+}
+
+#endif
+
 #endif // PLAY_IMPLEMENTATION
 
 #ifdef PLAY_IMPLEMENTATION
@@ -0,0 +1,221 @@
+//********************************************************************************************************************************
+// File:		PlayBenchmarks.cpp
+// Description:	A console program which times the performance-critical parts of Play.h
+// Platform:	Windows
+// Notes:		Run the Release configuration for meaningful numbers. Returns 1 if any of the results are wrong
+//				The job system timings only show how it scales when there's a core for each of its threads
+//********************************************************************************************************************************
+
+#define PLAY_IMPLEMENTATION
+#include "Play.h"
+#include <cstdio>
+#include <bitset>
+
+// Play.h's WinMain calls these, but this program starts from main() instead
+void MainGameEntry( PLAY_IGNORE_COMMAND_LINE ) {}
+bool MainGameUpdate( float ) { return true; }
+int MainGameExit( void ) { return 0; }
+
+// Returns the number of seconds since the given time
+double SecondsSince( std::chrono::high_resolution_clock::time_point start )
+{
+	return std::chrono::duration<double>( std::chrono::high_resolution_clock::now() - start ).count();
+}
+
+//********************************************************************************************************************************
+// Collision benchmarks
+//********************************************************************************************************************************
+
+// Times CollideCircles testing a moving circle against a packed array of circles spread over a 1280x720 display
+// > Returns false if it finds different hits to testing the circles one at a time
+bool BenchmarkCollideCircles()
+{
+	constexpr int CIRCLES = 4096;
+	constexpr int QUERIES = 20000;
+	constexpr float QUERY_RADIUS = 50.0f;
+
+	std::vector< float > vX( CIRCLES ), vY( CIRCLES ), vRadius( CIRCLES );
+	srand( 1 );
+	for( int i = 0; i < CIRCLES; i++ )
+	{
+		vX[i] = static_cast<float>( rand() % 1280 );
+		vY[i] = static_cast<float>( rand() % 720 );
+		vRadius[i] = static_cast<float>( 10 + rand() % 40 );
+	}
+
+	std::vector< uint32_t > vHitMasks( ( CIRCLES + 31 ) / 32 );
+	long long kernelHits = 0;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for( int q = 0; q < QUERIES; q++ )
+	{
+		Vector2f pos( static_cast<float>( q % 1280 ), static_cast<float>( ( q * 7 ) % 720 ) );
+		CollideCircles( pos, QUERY_RADIUS, vX.data(), vY.data(), vRadius.data(), CIRCLES, vHitMasks.data() );
+
+		for( uint32_t mask : vHitMasks )
+			kernelHits += std::bitset< 32 >( mask ).count();
+	}
+	double kernelSeconds = SecondsSince( start );
+
+	// The same tests one circle at a time
+	long long loopHits = 0;
+
+	start = std::chrono::high_resolution_clock::now();
+	for( int q = 0; q < QUERIES; q++ )
+	{
+		Vector2f pos( static_cast<float>( q % 1280 ), static_cast<float>( ( q * 7 ) % 720 ) );
+
+		for( int i = 0; i < CIRCLES; i++ )
+		{
+			float xDiff = vX[i] - pos.x;
+			float yDiff = vY[i] - pos.y;
+			float radii = vRadius[i] + QUERY_RADIUS;
+
+			if( ( xDiff * xDiff ) + ( yDiff * yDiff ) < radii * radii )
+				loopHits++;
+		}
+	}
+	double loopSeconds = SecondsSince( start );
+
+	double tests = static_cast<double>( CIRCLES ) * QUERIES;
+	printf( "CollideCircles (%s): %.0f million tests/s, %.1f million hits/s\n", CpuSupportsAvx() ? "AVX" : "SSE2", tests / kernelSeconds / 1e6, kernelHits / kernelSeconds / 1e6 );
+	printf( "One at a time:         %.0f million tests/s, %.1f million hits/s\n", tests / loopSeconds / 1e6, loopHits / loopSeconds / 1e6 );
+
+	if( kernelHits != loopHits )
+	{
+		printf( "  FAILED: CollideCircles found %lld hits but testing one at a time found %lld\n", kernelHits, loopHits );
+		return false;
+	}
+
+	return true;
+}
+
+//********************************************************************************************************************************
+// Job system tests and benchmarks
+//********************************************************************************************************************************
+
+// Checks that ParallelFor calls the function exactly once for every index, for a range of counts and grain sizes
+bool TestParallelForCoversEachIndexOnce()
+{
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance();
+
+	for( int rep = 0; rep < 50; rep++ )
+	{
+		int count = 100000 + ( rep * 37 );
+		int grainSize = ( rep % 3 == 0 ) ? 0 : ( rep * 13 ) + 1;
+		std::vector< std::atomic< int > > vCalls( count );
+
+		jobSystem.ParallelFor( count, [&]( int begin, int end )
+		{
+			for( int i = begin; i < end; i++ )
+				vCalls[i]++;
+		}, grainSize );
+
+		for( int i = 0; i < count; i++ )
+		{
+			if( vCalls[i] != 1 )
+			{
+				printf( "  FAILED: ParallelFor( %d, grain size %d ) called index %d %d times\n", count, grainSize, i, vCalls[i].load() );
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Checks that jobs started by a ParallelFor can run ParallelFors of their own
+bool TestNestedParallelFor()
+{
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance();
+	std::atomic< int > total{ 0 };
+
+	jobSystem.ParallelFor( 64, [&]( int begin, int end )
+	{
+		for( int i = begin; i < end; i++ )
+			jobSystem.ParallelFor( 1000, [&]( int innerBegin, int innerEnd ) { total += innerEnd - innerBegin; }, 50 );
+	}, 1 );
+
+	if( total != 64 * 1000 )
+	{
+		printf( "  FAILED: Nested ParallelFors covered %d indices instead of %d\n", total.load(), 64 * 1000 );
+		return false;
+	}
+	return true;
+}
+
+// Checks that starting more jobs than the job queues can hold still runs every one of them
+bool TestJobQueueOverflow()
+{
+	constexpr int JOBS = 10000;
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance();
+	PlayJobSystem::JobCounter counter;
+	std::atomic< int > runs{ 0 };
+
+	for( int i = 0; i < JOBS; i++ )
+		jobSystem.Run( counter, []( void* pData, int, int ) { ( *static_cast<std::atomic< int >*>( pData ) )++; }, &runs );
+	jobSystem.Wait( counter );
+
+	if( runs != JOBS )
+	{
+		printf( "  FAILED: %d of %d jobs ran\n", runs.load(), JOBS );
+		return false;
+	}
+	return true;
+}
+
+// Times starting and finishing jobs which do nothing, in batches of 1000 per Wait
+void BenchmarkEmptyJobs()
+{
+	constexpr int JOBS = 1000000;
+	constexpr int BATCH_SIZE = 1000;
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance();
+	PlayJobSystem::JobCounter counter;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for( int i = 0; i < JOBS; i += BATCH_SIZE )
+	{
+		for( int j = 0; j < BATCH_SIZE; j++ )
+			jobSystem.Run( counter, []( void*, int, int ) {}, nullptr );
+		jobSystem.Wait( counter );
+	}
+	double seconds = SecondsSince( start );
+
+	printf( "Empty jobs (Run + Wait): %.1f million jobs/s, %.0f ns each\n", JOBS / seconds / 1e6, seconds / JOBS * 1e9 );
+}
+
+// Times ParallelFor calls which are too small to be worth spreading over the threads, to show the cost of each call
+void BenchmarkParallelForCalls()
+{
+	constexpr int CALLS = 10000;
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance();
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	for( int i = 0; i < CALLS; i++ )
+		jobSystem.ParallelFor( 1024, []( int, int ) {}, 64 );
+	double seconds = SecondsSince( start );
+
+	printf( "ParallelFor (1024 indices in 16 ranges): %.2f us per call\n", seconds / CALLS * 1e6 );
+}
+
+// Takes an optional number of threads for the job system (one per core by default)
+int main( int argc, char* argv[] )
+{
+	printf( "PlayBuffer %s benchmarks\n\n", PLAY_VERSION );
+
+	bool bPassed = BenchmarkCollideCircles();
+
+	PlayJobSystem& jobSystem = PlayJobSystem::Instance( argc > 1 ? atoi( argv[1] ) : 0 );
+	int cores = static_cast<int>( std::thread::hardware_concurrency() );
+	printf( "\nJob system with %d threads on %d cores\n", jobSystem.GetThreadCount(), cores );
+	if( cores > 0 && jobSystem.GetThreadCount() > cores )
+		printf( "  (more threads than cores, so these timings show the cost of sharing the cores rather than throughput)\n" );
+	bPassed &= TestParallelForCoversEachIndexOnce();
+	bPassed &= TestNestedParallelFor();
+	bPassed &= TestJobQueueOverflow();
+	BenchmarkEmptyJobs();
+	BenchmarkParallelForCalls();
+	PlayJobSystem::Destroy();
+
+	printf( "\n%s\n", bPassed ? "All tests passed" : "Some tests FAILED" );
+	return bPassed ? 0 : 1;
+}